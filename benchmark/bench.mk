@@ -30,38 +30,31 @@ TWITTER_URL = https://github.com/ANLAB-KAIST/traces/releases/download/twitter_rv
 $(RAW_GRAPH_DIR)/twitter_rv.net.%.gz:
 	wget -P $(RAW_GRAPH_DIR) $(TWITTER_URL)
 
-$(RAW_GRAPH_DIR)/twitter_rv.net: $(RAW_GRAPH_DIR)/twitter_rv.net.00.gz $(RAW_GRAPH_DIR)/twitter_rv.net.01.gz $(RAW_GRAPH_DIR)/twitter_rv.net.02.gz $(RAW_GRAPH_DIR)/twitter_rv.net.03.gz
-	gunzip -c $^ > $@
-	touch $@
-
-$(RAW_GRAPH_DIR)/twitter.el: $(RAW_GRAPH_DIR)/twitter_rv.net
-	rm -f $@
-	ln -s twitter_rv.net $@
+# concatenated gzip files are a valid gzip file, Reader decompresses it as
+# it parses, so the uncompressed edge list is never written to disk
+$(RAW_GRAPH_DIR)/twitter.el.gz: $(RAW_GRAPH_DIR)/twitter_rv.net.00.gz $(RAW_GRAPH_DIR)/twitter_rv.net.01.gz $(RAW_GRAPH_DIR)/twitter_rv.net.02.gz $(RAW_GRAPH_DIR)/twitter_rv.net.03.gz
+	cat $^ > $@
 
-$(GRAPH_DIR)/twitter.sg: $(RAW_GRAPH_DIR)/twitter.el converter
+$(GRAPH_DIR)/twitter.sg: $(RAW_GRAPH_DIR)/twitter.el.gz converter
 	./converter -f $< -b $@
 
-# $(GRAPH_DIR)/twitter.wsg: $(RAW_GRAPH_DIR)/twitter.el converter
+# $(GRAPH_DIR)/twitter.wsg: $(RAW_GRAPH_DIR)/twitter.el.gz converter
 # 	./converter -f $< -wb $@
 
-# $(GRAPH_DIR)/twitterU.sg: $(RAW_GRAPH_DIR)/twitter.el converter
+# $(GRAPH_DIR)/twitterU.sg: $(RAW_GRAPH_DIR)/twitter.el.gz converter
 # 	./converter -sf $< -b $@
 
 ROAD_URL = http://www.dis.uniroma1.it/challenge9/data/USA-road-d/USA-road-d.USA.gr.gz
 $(RAW_GRAPH_DIR)/USA-road-d.USA.gr.gz:
 	wget -P $(RAW_GRAPH_DIR) $(ROAD_URL)
 
-$(RAW_GRAPH_DIR)/USA-road-d.USA.gr: $(RAW_GRAPH_DIR)/USA-road-d.USA.gr.gz
-	cd $(RAW_GRAPH_DIR)
-	gunzip < $< > $@
-
-$(GRAPH_DIR)/road.sg: $(RAW_GRAPH_DIR)/USA-road-d.USA.gr converter
+$(GRAPH_DIR)/road.sg: $(RAW_GRAPH_DIR)/USA-road-d.USA.gr.gz converter
 	./converter -f $< -b $@
 
-$(GRAPH_DIR)/road.wsg: $(RAW_GRAPH_DIR)/USA-road-d.USA.gr converter
+$(GRAPH_DIR)/road.wsg: $(RAW_GRAPH_DIR)/USA-road-d.USA.gr.gz converter
 	./converter -f $< -wb $@
 
-$(GRAPH_DIR)/roadU.sg: $(RAW_GRAPH_DIR)/USA-road-d.USA.gr converter
+$(GRAPH_DIR)/roadU.sg: $(RAW_GRAPH_DIR)/USA-road-d.USA.gr.gz converter
 	./converter -sf $< -b $@
 
 WEB_URL = https://sparse.tamu.edu/MM/LAW/sk-2005.tar.gz
@@ -0,0 +1,342 @@
+// Copyright (c) 2015, The Regents of the University of California (Regents)
+// See LICENSE.txt for license details
+
+#ifndef ALLOCATOR_H_
+#define ALLOCATOR_H_
+
+#include <linux/mman.h>
+#include <numa.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <type_traits>
+
+#include "numa_placement.h"
+
+
+/*
+GAP Benchmark Suite
+File:   Allocators
+
+Allocation policies for pvector's storage (which is never initialized)
+ - NewAllocator uses new[] (original behavior), only its storage can be
+   taken over with pvector::leak() and later freed with delete[], and it
+   grows in place with realloc (as the in-place builder already does)
+ - MmapAllocator maps anonymous memory and advises transparent huge pages
+ - HugeTLBAllocator maps explicit 2MB or 1GB huge pages (reserved with
+   vm.nr_hugepages or hugepages= at boot), if the pool can't satisfy a
+   request it warns once and falls back to transparent huge pages
+ - InterleaveAllocator spreads pages round-robin over NUMA nodes (libnuma)
+ - ParallelTouchAllocator maps memory and touches every page in parallel
+   with a static schedule, so pages land near the threads that use them
+ - RuntimeAllocator (pvector's default) uses the policy chosen for the
+   process (-A on command line, see CLBase), small allocations (under
+   kAllocMinBytes) and types with destructors always use new[], and 1GB
+   pages are only used for allocations of at least half a page
+ - All allocations are placed by the NUMA placement policy (see
+   numa_placement.h) before they are touched, so -N takes precedence
+ - AdviseArray applies the closest the policy can to arrays that have
+   already been allocated with new[] (e.g. CSR neighbors)
+*/
+
+
+enum class AllocPolicy {
+  kNew, kHugePages, kHugeTLB2M, kHugeTLB1G, kInterleave, kParallelTouch
+};
+
+static const size_t kAllocMinBytes = 1 << 20;
+
+inline AllocPolicy& AllocGlobalPolicy() {
+  static AllocPolicy policy = AllocPolicy::kNew;
+  return policy;
+}
+
+// Returns false if name isn't a recognized policy
+inline bool ParseAllocPolicy(const std::string &name, AllocPolicy *policy) {
+  if (name == "new")
+    *policy = AllocPolicy::kNew;
+  else if (name == "thp")
+    *policy = AllocPolicy::kHugePages;
+  else if (name == "huge2m")
+    *policy = AllocPolicy::kHugeTLB2M;
+  else if (name == "huge1g")
+    *policy = AllocPolicy::kHugeTLB1G;
+  else if (name == "interleave")
+    *policy = AllocPolicy::kInterleave;
+  else if (name == "parallel-touch")
+    *policy = AllocPolicy::kParallelTouch;
+  else
+    return false;
+  return true;
+}
+
+namespace alloc_internal {
+
+inline size_t PageBytes() {
+  static const size_t page_bytes = sysconf(_SC_PAGESIZE);
+  return page_bytes;
+}
+
+inline size_t RoundUp(size_t bytes, size_t multiple) {
+  return (bytes + multiple - 1) / multiple * multiple;
+}
+
+inline void* MapOrExit(size_t bytes, int extra_flags) {
+  void *ptr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | extra_flags, -1, 0);
+  if (ptr == MAP_FAILED) {
+    std::cout << "Couldn't map " << bytes << " bytes" << std::endl;
+    std::exit(-16);
+  }
+  return ptr;
+}
+
+// Advises transparent huge pages for whole pages within [ptr, ptr+bytes)
+inline void AdviseHugePages(void *ptr, size_t bytes) {
+  uintptr_t start = RoundUp(reinterpret_cast<uintptr_t>(ptr), PageBytes());
+  uintptr_t stop = (reinterpret_cast<uintptr_t>(ptr) + bytes) /
+                   PageBytes() * PageBytes();
+  if (stop > start)
+    madvise(reinterpret_cast<void*>(start), stop - start, MADV_HUGEPAGE);
+}
+
+// Only warns the first time (for any size)
+inline void WarnHugeTLBFallback(size_t huge_page_bytes) {
+  static bool warned = false;
+  if (!warned) {
+    std::cout << "Not enough " << (huge_page_bytes >> 20) << "MB huge pages, "
+              << "using transparent huge pages" << std::endl;
+    warned = true;
+  }
+}
+
+// Writes one byte per page with a static schedule, so (under first-touch)
+// each thread's share of the array is placed on its node
+inline void ParallelTouch(void *ptr, size_t bytes) {
+  char *begin = static_cast<char*>(ptr);
+  const int64_t num_pages = (bytes + PageBytes() - 1) / PageBytes();
+  #pragma omp parallel for schedule(static)
+  for (int64_t p = 0; p < num_pages; p++)
+    begin[p * PageBytes()] = 0;
+}
+
+}  // namespace alloc_internal
+
+
+template <typename T_>
+class NewAllocator {
+ public:
+  T_* allocate(size_t n) {
+    T_ *ptr = new T_[n];
+    NUMAPlace(ptr, n * sizeof(T_));
+    return ptr;
+  }
+
+  // Large allocations are remapped by realloc rather than copied, so the
+  // old and new storage never both take memory (types must be trivially
+  // copyable, storage from new[] is freed by delete[] either way)
+  T_* reallocate(T_ *ptr, size_t old_n, size_t n) {
+    static_assert(std::is_trivially_copyable<T_>::value,
+                  "only trivially copyable types can be realloc'd");
+    T_ *new_ptr = static_cast<T_*>(std::realloc(ptr, n * sizeof(T_)));
+    if (new_ptr == nullptr) {
+      std::cout << "Call to realloc() failed" << std::endl;
+      std::exit(-33);
+    }
+    if (n > old_n)
+      NUMAPlace(new_ptr + old_n, (n - old_n) * sizeof(T_));
+    return new_ptr;
+  }
+
+  void deallocate(T_ *ptr, size_t n) { delete[] ptr; }
+};
+
+
+template <typename T_>
+class MmapAllocator {
+ public:
+  T_* allocate(size_t n) {
+    size_t bytes = MappedBytes(n);
+    void *ptr = alloc_internal::MapOrExit(bytes, 0);
+    alloc_internal::AdviseHugePages(ptr, bytes);
+    NUMAPlace(ptr, bytes);
+    return static_cast<T_*>(ptr);
+  }
+
+  void deallocate(T_ *ptr, size_t n) { munmap(ptr, MappedBytes(n)); }
+
+ private:
+  static size_t MappedBytes(size_t n) {
+    return alloc_internal::RoundUp(std::max(n, size_t(1)) * sizeof(T_),
+                                   alloc_internal::PageBytes());
+  }
+};
+
+
+template <typename T_, int PageShift = 21>
+class HugeTLBAllocator {
+ public:
+  static const size_t kHugePageBytes = size_t(1) << PageShift;
+
+  T_* allocate(size_t n) {
+    size_t bytes = MappedBytes(n);
+    void *ptr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB |
+                     (PageShift << MAP_HUGE_SHIFT), -1, 0);
+    if (ptr == MAP_FAILED) {
+      // same (rounded up) length, so deallocate doesn't need to know
+      alloc_internal::WarnHugeTLBFallback(kHugePageBytes);
+      ptr = alloc_internal::MapOrExit(bytes, 0);
+      alloc_internal::AdviseHugePages(ptr, bytes);
+    }
+    NUMAPlace(ptr, bytes);
+    return static_cast<T_*>(ptr);
+  }
+
+  void deallocate(T_ *ptr, size_t n) { munmap(ptr, MappedBytes(n)); }
+
+ private:
+  static size_t MappedBytes(size_t n) {
+    return alloc_internal::RoundUp(std::max(n, size_t(1)) * sizeof(T_),
+                                   kHugePageBytes);
+  }
+};
+
+
+template <typename T_>
+class InterleaveAllocator {
+ public:
+  T_* allocate(size_t n) {
+    if (numa_available() < 0)
+      return MmapAllocator<T_>().allocate(n);
+    void *ptr = numa_alloc_interleaved(std::max(n, size_t(1)) * sizeof(T_));
+    if (ptr == nullptr) {
+      std::cout << "Couldn't map " << n * sizeof(T_) << " bytes" << std::endl;
+      std::exit(-16);
+    }
+    NUMAPlace(ptr, n * sizeof(T_));
+    return static_cast<T_*>(ptr);
+  }
+
+  void deallocate(T_ *ptr, size_t n) {
+    if (numa_available() < 0)
+      MmapAllocator<T_>().deallocate(ptr, n);
+    else
+      numa_free(ptr, std::max(n, size_t(1)) * sizeof(T_));
+  }
+};
+
+
+template <typename T_>
+class ParallelTouchAllocator {
+ public:
+  T_* allocate(size_t n) {
+    T_ *ptr = MmapAllocator<T_>().allocate(n);  // placed before touched
+    alloc_internal::ParallelTouch(ptr, n * sizeof(T_));
+    return ptr;
+  }
+
+  void deallocate(T_ *ptr, size_t n) {
+    MmapAllocator<T_>().deallocate(ptr, n);
+  }
+};
+
+
+// Policy is fixed when constructed, and which allocator is used only depends
+// on it and the number of elements, so deallocate picks the same one
+template <typename T_>
+class RuntimeAllocator {
+ public:
+  RuntimeAllocator() : policy_(AllocGlobalPolicy()) {}
+
+  T_* allocate(size_t n) {
+    switch (Choose(n)) {
+      case AllocPolicy::kHugePages:
+        return MmapAllocator<T_>().allocate(n);
+      case AllocPolicy::kHugeTLB2M:
+        return Huge2M().allocate(n);
+      case AllocPolicy::kHugeTLB1G:
+        return Huge1G().allocate(n);
+      case AllocPolicy::kInterleave:
+        return InterleaveAllocator<T_>().allocate(n);
+      case AllocPolicy::kParallelTouch:
+        return ParallelTouchAllocator<T_>().allocate(n);
+      default:
+        return NewAllocator<T_>().allocate(n);
+    }
+  }
+
+  void deallocate(T_ *ptr, size_t n) {
+    switch (Choose(n)) {
+      case AllocPolicy::kHugePages:
+        MmapAllocator<T_>().deallocate(ptr, n);
+        break;
+      case AllocPolicy::kHugeTLB2M:
+        Huge2M().deallocate(ptr, n);
+        break;
+      case AllocPolicy::kHugeTLB1G:
+        Huge1G().deallocate(ptr, n);
+        break;
+      case AllocPolicy::kInterleave:
+        InterleaveAllocator<T_>().deallocate(ptr, n);
+        break;
+      case AllocPolicy::kParallelTouch:
+        ParallelTouchAllocator<T_>().deallocate(ptr, n);
+        break;
+      default:
+        NewAllocator<T_>().deallocate(ptr, n);
+    }
+  }
+
+ private:
+  typedef HugeTLBAllocator<T_, 21> Huge2M;
+  typedef HugeTLBAllocator<T_, 30> Huge1G;
+
+  AllocPolicy Choose(size_t n) const {
+    const size_t bytes = n * sizeof(T_);
+    if ((bytes < kAllocMinBytes) || !std::is_trivially_destructible<T_>::value)
+      return AllocPolicy::kNew;
+    if ((policy_ == AllocPolicy::kHugeTLB1G) &&
+        (bytes < Huge1G::kHugePageBytes / 2))
+      return AllocPolicy::kHugeTLB2M;
+    return policy_;
+  }
+
+  AllocPolicy policy_;
+};
+
+
+// Applies policy (as far as possible) to array already allocated with new[]
+// and not yet touched, e.g. CSR neighbors
+template <typename T_>
+void AdviseArray(T_ *ptr, size_t n) {
+  const size_t bytes = n * sizeof(T_);
+  if ((ptr == nullptr) || (bytes < kAllocMinBytes))
+    return;
+  switch (AllocGlobalPolicy()) {
+    case AllocPolicy::kHugePages:
+    case AllocPolicy::kHugeTLB2M:
+    case AllocPolicy::kHugeTLB1G:
+      alloc_internal::AdviseHugePages(ptr, bytes);
+      break;
+    case AllocPolicy::kInterleave:
+      if (numa_available() >= 0)
+        NUMAPlaceRange(reinterpret_cast<char*>(ptr),
+                       reinterpret_cast<char*>(ptr) + bytes, -1);
+      break;
+    case AllocPolicy::kParallelTouch:
+      alloc_internal::ParallelTouch(ptr, bytes);
+      break;
+    default:
+      break;
+  }
+}
+
+#endif  // ALLOCATOR_H_
@@ -6,6 +6,8 @@
 #include <vector>
 #include <unistd.h> 
 
+// Only outgoing neighbors are used, so no inverse is made
+#define GAPBS_GRAPH_NEEDS kNeedsSquished
 #include "benchmark.h"
 #include "bitmap.h"
 #include "builder.h"
@@ -0,0 +1,45 @@
+// Copyright (c) 2015, The Regents of the University of California (Regents)
+// See LICENSE.txt for license details
+
+#ifndef BEL_FORMAT_H_
+#define BEL_FORMAT_H_
+
+#include <cinttypes>
+#include <cstring>
+
+#include "sg_format.h"
+
+
+/*
+GAP Benchmark Suite
+File:   Binary Edge List Format
+
+On-disk layout of binary edge lists (.bel & .bwel) shared by Reader and Writer
+ - BELHeader followed by num_edges fixed-size records, each record is
+   source ID, destination ID, and if weighted, the weight
+ - IDs are id_bytes wide (4 or 8), weights are weight_bytes wide (0 if none)
+   and of weight_kind (SGWeightKind, see sg_format.h)
+ - Records are packed, so if widths match those of EdgePair in memory, the
+   records can be read straight into an EdgeList
+*/
+
+
+static const char kBELMagic[8] = {'G', 'A', 'P', 'B', 'S', 'E', 'L', '\0'};
+static const uint32_t kBELVersion = 1;
+
+struct BELHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t id_bytes;
+  uint32_t weight_bytes;
+  uint32_t weight_kind;
+  int64_t num_edges;
+
+  size_t record_bytes() const { return 2*id_bytes + weight_bytes; }
+};
+
+inline bool BELHasMagic(const BELHeader &header) {
+  return std::memcmp(header.magic, kBELMagic, sizeof(kBELMagic)) == 0;
+}
+
+#endif  // BEL_FORMAT_H_
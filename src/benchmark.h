@@ -12,7 +12,9 @@
 #include <vector>
 
 #include "builder.h"
+#include "compressed_graph.h"
 #include "graph.h"
+#include "split_graph.h"
 #include "timer.h"
 #include "util.h"
 #include "writer.h"
@@ -25,19 +27,47 @@ Author: Scott Beamer
 Various helper functions to ease writing of kernels
 */
 
-// Default type signatures for commonly used types
+// Default type signatures for commonly used types, each kernel is also
+// built with 64-bit IDs for graphs that need them (see id_width.h)
+#ifdef GAPBS_64BIT_IDS
+typedef int64_t NodeID;
+#else
 typedef int32_t NodeID;
+#endif
+// Weight type is also picked at build time (make WEIGHT=..., see Makefile)
+#ifdef GAPBS_WEIGHT_T
+typedef GAPBS_WEIGHT_T WeightT;
+#else
 typedef int32_t WeightT;
+#endif
 typedef NodeWeight<NodeID, WeightT> WNode;
 
-typedef CSRGraph<NodeID> Graph;
-typedef CSRGraph<NodeID, WNode> WGraph;
-
-typedef BuilderBase<NodeID, NodeID, WeightT> Builder;
-typedef BuilderBase<NodeID, WNode, WeightT> WeightedBuilder;
-
-typedef WriterBase<NodeID, NodeID> Writer;
-typedef WriterBase<NodeID, WNode> WeightedWriter;
+// What kernel needs from its graph (see GraphNeeds in builder.h), a kernel
+// declares less by defining GAPBS_GRAPH_NEEDS before including this
+#ifndef GAPBS_GRAPH_NEEDS
+  #define GAPBS_GRAPH_NEEDS kNeedsAll
+#endif
+static const unsigned kGraphNeeds = GAPBS_GRAPH_NEEDS;
+static const bool kGraphInverse =
+    (kGraphNeeds & (kNeedsInverse | kNeedsLazyInverse)) != 0;
+static const bool kGraphLazyInverse =
+    kGraphInverse && !(kGraphNeeds & kNeedsInverse);
+
+#ifdef GAPBS_COMPRESSED
+typedef CompressedCSRGraph<NodeID, kGraphInverse> Graph;
+typedef CompressedBuilderBase<NodeID, WeightT, kGraphNeeds> Builder;
+#else
+typedef CSRGraph<NodeID, NodeID, kGraphInverse, kGraphLazyInverse> Graph;
+typedef BuilderBase<NodeID, NodeID, WeightT, kGraphNeeds> Builder;
+#endif
+template <typename WeightT_>
+using WeightedGraph = SplitCSRGraph<NodeID, WeightT_, kGraphInverse>;
+typedef WeightedGraph<WeightT> WGraph;
+typedef SplitBuilderBase<NodeID, WeightT, kGraphNeeds> WeightedBuilder;
+
+typedef WriterBase<NodeID, NodeID, kGraphInverse, kGraphLazyInverse> Writer;
+typedef WriterBase<NodeID, WNode, kGraphInverse, kGraphLazyInverse>
+    WeightedWriter;
 
 // Used to pick random non-zero degree starting points for search algorithms
 template <typename GraphT_> class SourcePicker {
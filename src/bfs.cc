@@ -9,11 +9,15 @@
 #include <unistd.h>
 #include <vector>
 
+// Inverse is only made once a search switches to bottom-up (see DOBFS), so
+// searches that never do don't pay for it
+#define GAPBS_GRAPH_NEEDS (kNeedsLazyInverse | kNeedsSorted | kNeedsSquished)
 #include "benchmark.h"
 #include "bitmap.h"
 #include "builder.h"
 #include "command_line.h"
 #include "graph.h"
+#include "numa_partition.h"
 #include "platform_atomics.h"
 #include "pvector.h"
 #include "sliding_queue.h"
@@ -31,6 +35,9 @@ It uses the alpha and beta parameters to determine whether to switch search
 directions. For representing the frontier, it uses a SlidingQueue for the
 top-down approach and a Bitmap for the bottom-up approach. To reduce
 false-sharing for the top-down approach, thread-local QueueBuffer's are used.
+With -N partitioned, the bottom-up approach processes each NUMA node's vertices
+with threads on that node (see NUMAPartitions). Incoming neighbors are only
+made before the first bottom-up step, which then reads them unchecked.
 
 To save time computing the number of edges exiting the frontier, this
 implementation precomputes the degrees in bulk at the beginning by storing
@@ -50,22 +57,20 @@ using namespace std;
 
 int64_t BUStep(const Graph &g, pvector<NodeID> &parent, Bitmap &front,
                Bitmap &next) {
-  int64_t awake_count = 0;
   next.reset();
-#pragma omp parallel for reduction(+ : awake_count) schedule(dynamic, 1024)
-  for (NodeID u = 0; u < g.num_nodes(); u++) {
+  NUMAPartitions parts(g.num_nodes());
+  return parts.SumLocal<int64_t>([&](NodeID u) {
     if (parent[u] < 0) {
-      for (NodeID v : g.in_neigh(u)) {
+      for (NodeID v : g.prepared_in_neigh(u)) {
         if (front.get_bit(v)) {
           parent[u] = v;
-          awake_count++;
           next.set_bit(u);
-          break;
+          return 1;
         }
       }
     }
-  }
-  return awake_count;
+    return 0;
+  });
 }
 
 int64_t TDStep(const Graph &g, pvector<NodeID> &parent,
@@ -175,6 +180,7 @@ pvector<NodeID> DOBFS(const Graph &g, NodeID source, int alpha = 15,
   while (!queue.empty()) {
     if (scout_count > edges_to_check / alpha) {
       int64_t awake_count, old_awake_count;
+      g.PrepareInverse();
       TIME_OP(t, QueueToBitmap(queue, front));
       // PrintStep("e", t.Seconds());
       awake_count = queue.size();
@@ -0,0 +1,92 @@
+// Copyright (c) 2015, The Regents of the University of California (Regents)
+// See LICENSE.txt for license details
+
+#ifndef BUILD_CACHE_H_
+#define BUILD_CACHE_H_
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cinttypes>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <system_error>
+
+
+/*
+GAP Benchmark Suite
+Class:  BuildCache
+
+On-disk cache of graphs built from edge lists, stored as serialized graphs
+so repeated runs on the same input load them instead of rebuilding
+ - Enabled by giving a directory (-C on command line, see CLBase)
+ - Entry name is a hash (64-bit FNV-1a) of the input's absolute path, size,
+   and modification time, together with the options that change what's
+   built (given by the builder, e.g. symmetrize, weights, reordering)
+ - Entries are written to a temporary file and renamed into place, so
+   concurrent runs never load a partial entry
+ - Entries are never removed, delete the directory to clear the cache
+*/
+
+class BuildCache {
+ public:
+  BuildCache() {}
+
+  // Disabled if dir is empty or input can't be found
+  BuildCache(const std::string &dir, const std::string &input,
+             const std::string &options, const std::string &suffix) {
+    struct stat input_stat;
+    if (dir.empty() || (stat(input.c_str(), &input_stat) != 0))
+      return;
+    std::error_code ec;
+    std::filesystem::path input_path = std::filesystem::absolute(input, ec);
+    std::string key = "v1|" + input_path.string() + "|" +
+                      std::to_string(input_stat.st_size) + "|" +
+                      std::to_string(input_stat.st_mtim.tv_sec) + "." +
+                      std::to_string(input_stat.st_mtim.tv_nsec) + "|" +
+                      options;
+    char hash[17];
+    std::snprintf(hash, sizeof(hash), "%016" PRIx64, FNV1a(key));
+    std::filesystem::create_directories(dir, ec);
+    path_ = (std::filesystem::path(dir) /
+             (input_path.stem().string() + "-" + hash + suffix)).string();
+  }
+
+  bool enabled() const { return !path_.empty(); }
+
+  bool Hit() const { return enabled() && std::filesystem::exists(path_); }
+
+  const std::string& path() const { return path_; }
+
+  // Reordering used for entry (written with it, if graph was reordered)
+  std::string permutation_path() const { return path_ + ".perm"; }
+
+  // Unique per process, so concurrent writers don't collide
+  std::string TempPath(const std::string &final_path) const {
+    return final_path + ".tmp" + std::to_string(getpid());
+  }
+
+  // Atomically replaces final_path with temp_path, false if it couldn't
+  bool Commit(const std::string &temp_path,
+              const std::string &final_path) const {
+    if (std::rename(temp_path.c_str(), final_path.c_str()) == 0)
+      return true;
+    std::remove(temp_path.c_str());
+    return false;
+  }
+
+ private:
+  static uint64_t FNV1a(const std::string &s) {
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : s) {
+      hash ^= c;
+      hash *= 1099511628211ull;
+    }
+    return hash;
+  }
+
+  std::string path_;
+};
+
+#endif  // BUILD_CACHE_H_
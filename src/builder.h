@@ -11,14 +11,39 @@
 #include <type_traits>
 #include <utility>
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+#include "allocator.h"
+#include "build_cache.h"
 #include "command_line.h"
+#include "compressed_graph.h"
 #include "generator.h"
 #include "graph.h"
+#include "id_width.h"
+#include "memory_tiering.h"
+#include "numa_placement.h"
 #include "platform_atomics.h"
 #include "pvector.h"
+#include "radix_sort.h"
 #include "reader.h"
+#include "reorder.h"
+#include "sg_format.h"
+#include "split_graph.h"
 #include "timer.h"
 #include "util.h"
+#include "writer.h"
+
+// What a kernel needs from its graph (or'd together), so builders can skip
+// the rest, weights are given by the graph's DestID_ type instead
+enum GraphNeeds : unsigned {
+  kNeedsInverse = 1,   // incoming neighbors (if directed)
+  kNeedsSorted = 2,    // neighborhoods sorted by ID
+  kNeedsSquished = 4,  // no self-loops or redundant edges (sorts too)
+  kNeedsLazyInverse = 8,  // incoming neighbors, made only if used (checked)
+  kNeedsAll = kNeedsInverse | kNeedsSorted | kNeedsSquished
+};
 
 /*
 GAP Benchmark Suite
@@ -30,30 +55,47 @@ Given arguements from the command line (cli), returns a built graph
    MakeGraphFromEL(edgelist) to perform actual graph construction
  - edgelist can be from file (reader) or synthetically generated (generator)
  - Common case: BuilderBase typedef'd (w/ params) to be Builder (benchmark.h)
+ - needs (see GraphNeeds) is fixed at compile time by the kernel, without
+   kNeedsInverse or kNeedsLazyInverse graphs have no inverse (MakeInverse is
+   false), with kNeedsInverse it's made before the graph is returned so
+   kernels read it unchecked, with only kNeedsLazyInverse it's made when
+   first used (LazyInverse is true), without
+   kNeedsSquished or kNeedsSorted built neighborhoods are left as they are
+   (in-place building and serialized graphs are always squished)
 */
 
 template <typename NodeID_, typename DestID_ = NodeID_,
-          typename WeightT_ = NodeID_, bool invert = true>
+          typename WeightT_ = NodeID_, unsigned needs = kNeedsAll>
 class BuilderBase {
+  static const bool invert =
+      (needs & (kNeedsInverse | kNeedsLazyInverse)) != 0;
+  static const bool lazy_inverse = invert && !(needs & kNeedsInverse);
+  static const bool kSquish = (needs & kNeedsSquished) != 0;
+  static const bool kSort = (needs & (kNeedsSorted | kNeedsSquished)) != 0;
+
   typedef EdgePair<NodeID_, DestID_> Edge;
-  typedef pvector<Edge> EdgeList;
+  typedef pvector<Edge, NewAllocator<Edge>> EdgeList;
+  typedef CSRGraph<NodeID_, DestID_, invert, lazy_inverse> CSRGraphT;
+  typedef typename CSRGraphT::Index Index;
+  typedef Reader<NodeID_, DestID_, WeightT_, invert, lazy_inverse> ReaderT;
+  typedef WriterBase<NodeID_, DestID_, invert, lazy_inverse> WriterT;
 
   const CLBase &cli_;
   bool symmetrize_;
   bool needs_weights_;
   bool in_place_ = false;
+  bool partitioned_ = false;
   int64_t num_nodes_ = -1;
 
+protected:
+  bool tier_neighbors_ = true;
+
 public:
   explicit BuilderBase(const CLBase &cli) : cli_(cli) {
     symmetrize_ = cli_.symmetrize();
     needs_weights_ = !std::is_same<NodeID_, DestID_>::value;
     in_place_ = cli_.in_place();
-    if (in_place_ && needs_weights_) {
-      std::cout << "In-place building (-m) does not support weighted graphs"
-                << std::endl;
-      exit(-30);
-    }
+    partitioned_ = cli_.build_alg() == "partitioned";
   }
 
   DestID_ GetSource(EdgePair<NodeID_, NodeID_> e) { return e.u; }
@@ -62,6 +104,68 @@ public:
     return NodeWeight<NodeID_, WeightT_>(e.u, e.v.w);
   }
 
+  // Gives both directions a and b of a symmetrized edge the smallest weight
+  // either had (if weighted)
+  static void KeepMinWeight(NodeID_ &a, NodeID_ &b) {}
+
+  static void KeepMinWeight(NodeWeight<NodeID_, WeightT_> &a,
+                            NodeWeight<NodeID_, WeightT_> &b) {
+    a.w = b.w = std::min(a.w, b.w);
+  }
+
+  // Orders neighbors only by ID (ignoring weights)
+  static bool IDLess(const DestID_ &a, const DestID_ &b) {
+    return static_cast<NodeID_>(a) < static_cast<NodeID_>(b);
+  }
+
+  // Keys for radix sorting (see radix_sort.h) that order like operator<,
+  // except weighted edges with 64-bit IDs don't fit in 128 bits with their
+  // weights, so their keys leave them out (see KeepMinWeightRuns)
+  static const int kDestKeyBits = std::is_same<NodeID_, DestID_>::value ?
+      8*sizeof(NodeID_) : 8*(sizeof(NodeID_) + sizeof(WeightT_));
+  static const bool kWeightInEdgeKey = 8*sizeof(NodeID_) + kDestKeyBits <= 128;
+  static const int kEdgeKeyBits = kWeightInEdgeKey ?
+      8*sizeof(NodeID_) + kDestKeyBits : 16*sizeof(NodeID_);
+  typedef typename std::conditional<(kDestKeyBits > 64), unsigned __int128,
+                                    uint64_t>::type DestKeyT;
+  typedef typename std::conditional<(kEdgeKeyBits > 64), unsigned __int128,
+                                    uint64_t>::type EdgeKeyT;
+
+  static DestKeyT DestKey(const DestID_ &v) { return NeighborKey(v); }
+
+  static EdgeKeyT EdgeKey(const Edge &e) {
+    if constexpr (kWeightInEdgeKey)
+      return (EdgeKeyT(OrderedBits(e.u)) << kDestKeyBits) | DestKey(e.v);
+    else
+      return (EdgeKeyT(OrderedBits(e.u)) << (8*sizeof(NodeID_))) |
+             OrderedBits(static_cast<NodeID_>(e.v));
+  }
+
+  // Gives first edge of each run of the same edge (sorted without weights)
+  // the run's lowest weight, since squishing only keeps that one, each run
+  // is done by the block it starts in (only weights of run starts are
+  // written, so neighboring blocks can still compare IDs)
+  static void KeepMinWeightRuns(EdgeList &el) {
+    const int64_t num_edges = el.size();
+    const int64_t block_size = 1 << 16;
+    auto same_edge = [&el](int64_t a, int64_t b) {
+      return (el[a].u == el[b].u) && (el[a].v.v == el[b].v.v);
+    };
+#pragma omp parallel for schedule(dynamic, 16)
+    for (int64_t start = 0; start < num_edges; start += block_size) {
+      const int64_t block_end = std::min(num_edges, start + block_size);
+      int64_t i = start;
+      while ((i > 0) && (i < block_end) && same_edge(i, i - 1))
+        i++;
+      while (i < block_end) {
+        int64_t j = i + 1;
+        for (; (j < num_edges) && same_edge(i, j); j++)
+          el[i].v.w = std::min(el[i].v.w, el[j].v.w);
+        i = j;
+      }
+    }
+  }
+
   NodeID_ FindMaxNodeID(const EdgeList &el) {
     NodeID_ max_seen = 0;
 #pragma omp parallel for reduction(max : max_seen)
@@ -97,198 +201,301 @@ public:
     return sums;
   }
 
-  static pvector<SGOffset> ParallelPrefixSum(const pvector<NodeID_> &degrees) {
-    const size_t block_size = 1 << 20;
-    const size_t num_blocks = (degrees.size() + block_size - 1) / block_size;
-    pvector<SGOffset> local_sums(num_blocks);
-#pragma omp parallel for
-    for (size_t block = 0; block < num_blocks; block++) {
-      SGOffset lsum = 0;
-      size_t block_end = std::min((block + 1) * block_size, degrees.size());
-      for (size_t i = block * block_size; i < block_end; i++)
-        lsum += degrees[i];
-      local_sums[block] = lsum;
-    }
-    pvector<SGOffset> bulk_prefix(num_blocks + 1);
-    SGOffset total = 0;
-    for (size_t block = 0; block < num_blocks; block++) {
-      bulk_prefix[block] = total;
-      total += local_sums[block];
-    }
-    bulk_prefix[num_blocks] = total;
-    pvector<SGOffset> prefix(degrees.size() + 1);
-#pragma omp parallel for
-    for (size_t block = 0; block < num_blocks; block++) {
-      SGOffset local_total = bulk_prefix[block];
-      size_t block_end = std::min((block + 1) * block_size, degrees.size());
-      for (size_t i = block * block_size; i < block_end; i++) {
-        prefix[i] = local_total;
-        local_total += degrees[i];
-      }
-    }
-    prefix[degrees.size()] = bulk_prefix[num_blocks];
-    return prefix;
+  // Sorts every neighborhood in place, without removing any edges
+  void SortCSR(const Index &index) {
+#pragma omp parallel for schedule(dynamic, 1024)
+    for (NodeID_ n = 0; n < num_nodes_; n++)
+      SortNeighborhood(index[n], index[n + 1]);
   }
 
-  // Removes self-loops and redundant edges
+  // Removes self-loops and redundant edges, compacting the neighbors within
+  // their existing storage (which is then shrunk), so the squished graph
+  // doesn't need memory of its own
   // Side effect: neighbor IDs will be sorted
-  void SquishCSR(const CSRGraph<NodeID_, DestID_, invert> &g, bool transpose,
-                 DestID_ ***sq_index, DestID_ **sq_neighs) {
-    pvector<NodeID_> diffs(g.num_nodes());
-    DestID_ *n_start, *n_end;
-#pragma omp parallel for private(n_start, n_end)
-    for (NodeID_ n = 0; n < g.num_nodes(); n++) {
-      if (transpose) {
-        n_start = g.in_neigh(n).begin();
-        n_end = g.in_neigh(n).end();
-      } else {
-        n_start = g.out_neigh(n).begin();
-        n_end = g.out_neigh(n).end();
-      }
-      std::sort(n_start, n_end);
+  void SquishCSRInPlace(Index *index, DestID_ **neighs) {
+    pvector<SGOffset> offsets(num_nodes_ + 1);
+    pvector<NodeID_> diffs(num_nodes_);
+#pragma omp parallel for schedule(dynamic, 1024)
+    for (NodeID_ n = 0; n < num_nodes_; n++) {
+      DestID_ *n_start = (*index)[n];
+      DestID_ *n_end = (*index)[n + 1];
+      SortNeighborhood(n_start, n_end);
       DestID_ *new_end = std::unique(n_start, n_end);
       new_end = std::remove(n_start, new_end, n);
       diffs[n] = new_end - n_start;
+      offsets[n] = n_start - *neighs;
     }
+    offsets[num_nodes_] = (*index)[num_nodes_] - *neighs;
     pvector<SGOffset> sq_offsets = ParallelPrefixSum(diffs);
-    *sq_neighs = new DestID_[sq_offsets[g.num_nodes()]];
-    std::cout << "sq_neighs: " << *sq_neighs << " ; "
-              << static_cast<intptr_t>(reinterpret_cast<intptr_t>(*sq_neighs))
-              << "\n"
-              << std::flush;
-    *sq_index = CSRGraph<NodeID_, DestID_>::GenIndex(sq_offsets, *sq_neighs);
-#pragma omp parallel for private(n_start)
-    for (NodeID_ n = 0; n < g.num_nodes(); n++) {
-      if (transpose)
-        n_start = g.in_neigh(n).begin();
+    CompactNeighs(*neighs, offsets, sq_offsets);
+    index->Release();
+    if (sq_offsets[num_nodes_] != offsets[num_nodes_]) {
+      size_t new_size = sq_offsets[num_nodes_] * sizeof(DestID_);
+      *neighs = static_cast<DestID_ *>(std::realloc(*neighs, new_size));
+      if (*neighs == nullptr) {
+        std::cout << "Call to realloc() failed" << std::endl;
+        exit(-33);
+      }
+    }
+    *index = Index(sq_offsets.data(), num_nodes_, *neighs);
+  }
+
+  // Moves first sq_offsets[n+1]-sq_offsets[n] neighbors of each vertex n
+  // left from offsets[n] to sq_offsets[n], the shift (offsets[n] minus
+  // sq_offsets[n]) is non-decreasing, so it is done from the start in rounds
+  //  - if a round's neighbors fit in the shift of its first vertex, no
+  //    destination is the source of another vertex, so they are copied
+  //    directly
+  //  - otherwise (small shifts) the round's neighbors are staged through a
+  //    buffer of a small fraction of the neighbors
+  void CompactNeighs(DestID_ *neighs, const pvector<SGOffset> &offsets,
+                     const pvector<SGOffset> &sq_offsets) {
+    auto shift = [&](NodeID_ n) { return offsets[n] - sq_offsets[n]; };
+    auto degree = [&](NodeID_ n) { return sq_offsets[n + 1] - sq_offsets[n]; };
+    const SGOffset stage_size = std::max(SGOffset(1) << 16,
+                                         sq_offsets[num_nodes_] / 64);
+    pvector<DestID_> stage;
+    // vertices before the first with a shift stay where they are
+    NodeID_ a = 0, first_hi = num_nodes_;
+    while (a < first_hi) {
+      NodeID_ mid = a + (first_hi - a) / 2;
+      if (shift(mid) == 0)
+        a = mid + 1;
       else
-        n_start = g.out_neigh(n).begin();
-      std::copy(n_start, n_start + diffs[n], (*sq_index)[n]);
+        first_hi = mid;
+    }
+    while (a < num_nodes_) {
+      const bool direct = shift(a) >= stage_size;
+      const SGOffset limit = direct ? shift(a) : stage_size;
+      NodeID_ lo = a, hi = num_nodes_;
+      while (lo < hi) {
+        NodeID_ mid = hi - (hi - lo) / 2;
+        if (sq_offsets[mid] - sq_offsets[a] <= limit)
+          lo = mid;
+        else
+          hi = mid - 1;
+      }
+      const NodeID_ b = lo;
+      if (b == a) {
+        // vertex too big for a round, copying left is safe by itself
+        std::copy(neighs + offsets[a], neighs + offsets[a] + degree(a),
+                  neighs + sq_offsets[a]);
+        a++;
+        continue;
+      }
+      const bool big_round = sq_offsets[b] - sq_offsets[a] > (1 << 16);
+      if (direct) {
+#pragma omp parallel for schedule(dynamic, 1024) if (big_round)
+        for (NodeID_ n = a; n < b; n++)
+          std::copy(neighs + offsets[n], neighs + offsets[n] + degree(n),
+                    neighs + sq_offsets[n]);
+      } else {
+        if (stage.empty())
+          stage.resize(stage_size);
+#pragma omp parallel for schedule(dynamic, 1024) if (big_round)
+        for (NodeID_ n = a; n < b; n++)
+          std::copy(neighs + offsets[n], neighs + offsets[n] + degree(n),
+                    stage.begin() + (sq_offsets[n] - sq_offsets[a]));
+#pragma omp parallel for if (big_round)
+        for (SGOffset i = sq_offsets[a]; i < sq_offsets[b]; i++)
+          neighs[i] = stage[i - sq_offsets[a]];
+      }
+      a = b;
     }
   }
 
-  CSRGraph<NodeID_, DestID_, invert>
-  SquishGraph(const CSRGraph<NodeID_, DestID_, invert> &g) {
-    DestID_ **out_index, *out_neighs, **in_index, *in_neighs;
-    SquishCSR(g, false, &out_index, &out_neighs);
-    if (g.directed()) {
-      if (invert)
-        SquishCSR(g, true, &in_index, &in_neighs);
-      return CSRGraph<NodeID_, DestID_, invert>(
-          g.num_nodes(), out_index, out_neighs, in_index, in_neighs);
-    } else {
-      return CSRGraph<NodeID_, DestID_, invert>(g.num_nodes(), out_index,
-                                                out_neighs);
+  // Converts sorted edges of el in place into outgoing neighbors (squishing
+  // out self loops and redundant edges), which are written to the front of
+  // el's storage, also counts degrees
+  // Since neighbors are smaller than edges, blocks of edges are converted in
+  // parallel in rounds, and each round only writes over space of edges from
+  // earlier rounds (which have already been read)
+  SGOffset SquishToNeighs(EdgeList &el, pvector<NodeID_> &degrees) {
+    const int64_t num_in = el.size();
+    const int64_t block_size = 1 << 16;
+    const int64_t num_blocks = (num_in + block_size - 1) / block_size;
+    // keeps edge if not a self loop and not the same as the edge before it
+    auto squish_block = [&](int64_t b, Edge prev, DestID_ *out) {
+      int64_t block_end = std::min(num_in, (b + 1) * block_size);
+      NodeID_ run_u = -1;
+      NodeID_ run_degree = 0;
+      int64_t kept = 0;
+      for (int64_t i = b * block_size; i < block_end; i++) {
+        Edge e = el[i];
+        if ((e.u != e.v) && ((i == 0) || !(e == prev))) {
+          if (out != nullptr) {
+            out[kept] = e.v;
+          } else {
+            // edges are sorted, so add to degrees once per run of a source
+            if (e.u != run_u) {
+              if (run_degree != 0)
+                fetch_and_add(degrees[run_u], run_degree);
+              run_u = e.u;
+              run_degree = 0;
+            }
+            run_degree++;
+          }
+          kept++;
+        }
+        prev = e;
+      }
+      if (run_degree != 0)
+        fetch_and_add(degrees[run_u], run_degree);
+      return kept;
+    };
+    // count pass (read-only) finds where each block's neighbors start
+    pvector<SGOffset> block_starts(num_blocks + 1);
+#pragma omp parallel for schedule(dynamic, 16)
+    for (int64_t b = 0; b < num_blocks; b++) {
+      Edge prev = el[std::max(int64_t(0), b * block_size - 1)];
+      block_starts[b] = squish_block(b, prev, nullptr);
+    }
+    SGOffset total = 0;
+    for (int64_t b = 0; b < num_blocks; b++) {
+      SGOffset block_total = block_starts[b];
+      block_starts[b] = total;
+      total += block_total;
+    }
+    block_starts[num_blocks] = total;
+    // write pass, edges before block b0 have already been converted
+    DestID_ *neighs = reinterpret_cast<DestID_ *>(el.data());
+    int64_t b0 = 0;
+    while (b0 < num_blocks) {
+      int64_t b1 = b0 * sizeof(Edge) / sizeof(DestID_);
+      b1 = std::min(num_blocks, std::max(b0 + 1, b1));
+      Edge round_prev = el[std::max(int64_t(0), b0 * block_size - 1)];
+#pragma omp parallel for schedule(dynamic, 1)
+      for (int64_t b = b0; b < b1; b++) {
+        Edge prev = b == b0 ? round_prev : el[b * block_size - 1];
+        squish_block(b, prev, neighs + block_starts[b]);
+      }
+      b0 = b1;
+    }
+    return total;
+  }
+
+  // Moves neighbors of each vertex n right by shifts[n+1] (non-decreasing)
+  // Done from the end in rounds, where each round is a range of vertices
+  // whose neighbors take up no more space than the range's smallest shift,
+  // so within a round no destination is the source of another vertex
+  void SpreadNeighs(DestID_ *neighs, const pvector<SGOffset> &offsets,
+                    const pvector<SGOffset> &shifts) {
+    NodeID_ b = num_nodes_;
+    while ((b > 0) && (shifts[b] != 0)) {
+      if (offsets[b] - offsets[b - 1] > shifts[b]) {
+        // vertex overlaps its own destination
+        std::copy_backward(neighs + offsets[b - 1], neighs + offsets[b],
+                           neighs + offsets[b] + shifts[b]);
+        b--;
+        continue;
+      }
+      NodeID_ lo = 0, hi = b - 1;
+      while (lo < hi) {
+        NodeID_ mid = lo + (hi - lo) / 2;
+        if (offsets[b] - offsets[mid] <= shifts[mid + 1])
+          hi = mid;
+        else
+          lo = mid + 1;
+      }
+      const NodeID_ a = lo;
+      const bool big_round = offsets[b] - offsets[a] > (1 << 16);
+#pragma omp parallel for schedule(dynamic, 1024) if (big_round)
+      for (NodeID_ n = a; n < b; n++) {
+        if (shifts[n + 1] != 0)
+          std::copy(neighs + offsets[n], neighs + offsets[n + 1],
+                    neighs + offsets[n] + shifts[n + 1]);
+      }
+      b = a;
     }
   }
 
   /*
   In-Place Graph Building Steps
-    - sort edges and squish (remove self loops and redundant edges)
-    - overwrite EdgeList's memory with outgoing neighbors
+    - sort edges (in place radix sort), by weight too so squishing keeps the
+      lowest weight of redundant edges (or if weights aren't in the keys,
+      give the first of them the lowest weight)
+    - overwrite EdgeList's memory with outgoing neighbors, while squishing
+      (removing self loops and redundant edges)
     - if graph not being symmetrized
-      - finalize structures and make incoming structures if requested
+      - finalize structures (incoming ones are made by graph when needed)
     - if being symmetrized
       - search for needed inverses, make room for them, add them in place
+  All steps are parallel
   */
-  void MakeCSRInPlace(EdgeList &el, DestID_ ***index, DestID_ **neighs,
-                      DestID_ ***inv_index, DestID_ **inv_neighs) {
+  void MakeCSRInPlace(EdgeList &el, Index *index, DestID_ **neighs) {
     // preprocess EdgeList - sort & squish in place
-    std::sort(el.begin(), el.end());
-    auto new_end = std::unique(el.begin(), el.end());
-    el.resize(new_end - el.begin());
-    auto self_loop = [](Edge e) { return e.u == e.v; };
-    new_end = std::remove_if(el.begin(), el.end(), self_loop);
-    el.resize(new_end - el.begin());
-    // analyze EdgeList and repurpose it for outgoing edges
-    pvector<NodeID_> degrees = CountDegrees(el, false);
-    pvector<SGOffset> offsets = ParallelPrefixSum(degrees);
-    pvector<NodeID_> indegrees = CountDegrees(el, true);
+    InPlaceRadixSort(el.begin(), el.end(),
+                     [](const Edge &e) { return EdgeKey(e); });
+    if constexpr (!kWeightInEdgeKey)
+      KeepMinWeightRuns(el);
+    // repurpose EdgeList for outgoing edges
+    pvector<NodeID_> degrees(num_nodes_, 0);
+    size_t num_edges = SquishToNeighs(el, degrees);
     *neighs = reinterpret_cast<DestID_ *>(el.data());
-    for (Edge e : el)
-      (*neighs)[offsets[e.u]++] = e.v;
-    size_t num_edges = el.size();
     el.leak();
-    // revert offsets by shifting them down
-    for (NodeID_ n = num_nodes_; n >= 0; n--)
-      offsets[n] = n != 0 ? offsets[n - 1] : 0;
+    pvector<SGOffset> offsets = ParallelPrefixSum(degrees);
     if (!symmetrize_) { // not going to symmetrize so no need to add edges
       size_t new_size = num_edges * sizeof(DestID_);
       *neighs = static_cast<DestID_ *>(std::realloc(*neighs, new_size));
-      *index = CSRGraph<NodeID_, DestID_>::GenIndex(offsets, *neighs);
-      if (invert) { // create inv_neighs & inv_index for incoming edges
-        pvector<SGOffset> inoffsets = ParallelPrefixSum(indegrees);
-        *inv_neighs = new DestID_[inoffsets[num_nodes_]];
-        std::cout << "inv_neighs: " << *inv_neighs << " ; "
-                  << static_cast<intptr_t>(
-                         reinterpret_cast<intptr_t>(*inv_neighs))
-                  << "\n"
-                  << std::flush;
-        *inv_index =
-            CSRGraph<NodeID_, DestID_>::GenIndex(inoffsets, *inv_neighs);
-        for (NodeID_ u = 0; u < num_nodes_; u++) {
-          for (DestID_ *it = (*index)[u]; it < (*index)[u + 1]; it++) {
-            NodeID_ v = static_cast<NodeID_>(*it);
-            (*inv_neighs)[inoffsets[v]] = u;
-            inoffsets[v]++;
-          }
-        }
-      }
+      *index = Index(offsets.data(), num_nodes_, *neighs);
     } else { // symmetrize graph by adding missing inverse edges
       // Step 1 - count number of needed inverses
       pvector<NodeID_> invs_needed(num_nodes_, 0);
+#pragma omp parallel for schedule(dynamic, 1024)
       for (NodeID_ u = 0; u < num_nodes_; u++) {
         for (SGOffset i = offsets[u]; i < offsets[u + 1]; i++) {
           DestID_ v = (*neighs)[i];
           bool inv_found =
               std::binary_search(*neighs + offsets[v], *neighs + offsets[v + 1],
-                                 static_cast<DestID_>(u));
+                                 static_cast<DestID_>(u), IDLess);
           if (!inv_found)
-            invs_needed[v]++;
+            fetch_and_add(invs_needed[v], 1);
         }
       }
       // increase offsets to account for missing inverses, realloc neighs
-      SGOffset total_missing_inv = 0;
-      for (NodeID_ n = 0; n <= num_nodes_; n++) {
-        offsets[n] += total_missing_inv;
-        total_missing_inv += invs_needed[n];
-      }
-      size_t newsize = (offsets[num_nodes_] * sizeof(DestID_));
+      pvector<SGOffset> missing_before = ParallelPrefixSum(invs_needed);
+      SGOffset total_missing_inv = missing_before[num_nodes_];
+      size_t newsize = (offsets[num_nodes_] + total_missing_inv) *
+                       sizeof(DestID_);
       *neighs = static_cast<DestID_ *>(std::realloc(*neighs, newsize));
       if (*neighs == nullptr) {
         std::cout << "Call to realloc() failed" << std::endl;
         exit(-33);
       }
       // Step 2 - spread out existing neighs to make room for inverses
-      //   copies backwards (overwrites) and inserts free space at starts
-      SGOffset tail_index = offsets[num_nodes_] - 1;
-      for (NodeID_ n = num_nodes_ - 1; n >= 0; n--) {
-        SGOffset new_start = offsets[n] + invs_needed[n];
-        for (SGOffset i = offsets[n + 1] - 1; i >= new_start; i--) {
-          (*neighs)[tail_index] = (*neighs)[i - total_missing_inv];
-          tail_index--;
-        }
-        total_missing_inv -= invs_needed[n];
-        tail_index -= invs_needed[n];
+      //   inserts free space at starts (vertex n moves by missing up to n+1)
+      SpreadNeighs(*neighs, offsets, missing_before);
+      // afterwards, reuse missing_before for where existing neighs start
+#pragma omp parallel for
+      for (NodeID_ n = 0; n <= num_nodes_; n++) {
+        offsets[n] += missing_before[n];
+        if (n < num_nodes_)
+          missing_before[n] = offsets[n] + invs_needed[n];
       }
+      const pvector<SGOffset> &existing_start = missing_before;
       // Step 3 - add missing inverse edges into free spaces from Step 2
+#pragma omp parallel for schedule(dynamic, 1024)
       for (NodeID_ u = 0; u < num_nodes_; u++) {
-        for (SGOffset i = offsets[u] + invs_needed[u]; i < offsets[u + 1];
-             i++) {
-          DestID_ v = (*neighs)[i];
-          bool inv_found = std::binary_search(
-              *neighs + offsets[v] + invs_needed[v], *neighs + offsets[v + 1],
-              static_cast<DestID_>(u));
-          if (!inv_found) {
-            (*neighs)[offsets[v] + invs_needed[v] - 1] =
-                static_cast<DestID_>(u);
-            invs_needed[v]--;
+        for (SGOffset i = existing_start[u]; i < offsets[u + 1]; i++) {
+          // only IDs are read here, weights of edges with both directions
+          // are only touched by the thread of the lower endpoint
+          NodeID_ v = static_cast<NodeID_>((*neighs)[i]);
+          DestID_ *v_end = *neighs + offsets[v + 1];
+          DestID_ *inv = std::lower_bound(*neighs + existing_start[v], v_end,
+                                          static_cast<DestID_>(u), IDLess);
+          if ((inv != v_end) && (static_cast<NodeID_>(*inv) == u)) {
+            if (u < v)
+              KeepMinWeight((*neighs)[i], *inv);
+          } else {
+            NodeID_ slot = fetch_and_add(invs_needed[v], -1) - 1;
+            (*neighs)[offsets[v] + slot] = GetSource(Edge(u, (*neighs)[i]));
           }
         }
       }
+#pragma omp parallel for schedule(dynamic, 1024)
       for (NodeID_ n = 0; n < num_nodes_; n++)
-        std::sort(*neighs + offsets[n], *neighs + offsets[n + 1]);
-      *index = CSRGraph<NodeID_, DestID_>::GenIndex(offsets, *neighs);
+        SortNeighborhood(*neighs + offsets[n], *neighs + offsets[n + 1]);
+      *index = Index(offsets.data(), num_nodes_, *neighs);
     }
   }
 
@@ -296,19 +503,21 @@ public:
   Graph Bulding Steps (for CSR):
     - Read edgelist once to determine vertex degrees (CountDegrees)
     - Determine vertex offsets by a prefix sum (ParallelPrefixSum)
-    - Allocate storage and set points according to offsets (GenIndex)
+    - Allocate storage and make index according to offsets (Index)
     - Copy edges into storage
   */
-  void MakeCSR(const EdgeList &el, bool transpose, DestID_ ***index,
+  void MakeCSR(const EdgeList &el, bool transpose, Index *index,
                DestID_ **neighs) {
     pvector<NodeID_> degrees = CountDegrees(el, transpose);
     pvector<SGOffset> offsets = ParallelPrefixSum(degrees);
     *neighs = new DestID_[offsets[num_nodes_]];
+    NUMAPlaceNeighs(*neighs, offsets.data(), num_nodes_);
+    AdviseArray(*neighs, offsets[num_nodes_]);
     std::cout << "neighs: " << *neighs << " ; "
               << static_cast<intptr_t>(reinterpret_cast<intptr_t>(*neighs))
               << "\n"
               << std::flush;
-    *index = CSRGraph<NodeID_, DestID_>::GenIndex(offsets, *neighs);
+    *index = Index(offsets.data(), num_nodes_, *neighs);
 #pragma omp parallel for
     for (auto it = el.begin(); it < el.end(); it++) {
       Edge e = *it;
@@ -319,10 +528,106 @@ public:
             GetSource(e);
     }
   }
+  /*
+  Partitioned Graph Building Steps (for CSR, without atomics):
+    - Split vertices into ranges and the edgelist into one block per thread
+    - Each block makes its own histogram of how many edges go to each range
+    - Prefix sum over (range, block) gives every block a private place in
+      each range's part of a temporary edgelist to scatter its edges to
+    - Each range is processed by a single thread, which counts its vertices'
+      degrees, sets their offsets, and copies their edges into storage
+  Uses extra memory for the temporary edgelist, but no atomics, so threads
+  don't contend for the counters of high-degree vertices
+  */
+  void MakeCSRPartitioned(const EdgeList &el, bool transpose,
+                          Index *index, DestID_ **neighs) {
+    const bool add_out = symmetrize_ || !transpose;
+    const bool add_in = symmetrize_ || transpose;
+    int64_t num_blocks = 1;
+    #ifdef _OPENMP
+      num_blocks = omp_get_max_threads();
+    #endif
+    const int64_t ranges_per_block = 64;
+    int range_bits = 0;
+    while ((int64_t(1) << range_bits) * num_blocks * ranges_per_block <
+           num_nodes_)
+      range_bits++;
+    const int64_t range_size = int64_t(1) << range_bits;
+    const int64_t num_ranges = (num_nodes_ + range_size - 1) / range_size;
+    const int64_t block_size = (el.size() + num_blocks - 1) / num_blocks;
+    pvector<SGOffset> block_counts(num_blocks * num_ranges, 0);
+#pragma omp parallel for schedule(static, 1)
+    for (int64_t b = 0; b < num_blocks; b++) {
+      SGOffset *counts = block_counts.data() + b * num_ranges;
+      int64_t block_end = std::min(int64_t(el.size()), (b+1) * block_size);
+      for (int64_t i = b * block_size; i < block_end; i++) {
+        Edge e = el[i];
+        if (add_out)
+          counts[e.u >> range_bits]++;
+        if (add_in)
+          counts[static_cast<NodeID_>(e.v) >> range_bits]++;
+      }
+    }
+    // ordered by range then block, so each range's edges are contiguous
+    pvector<SGOffset> range_starts(num_ranges + 1);
+    SGOffset total = 0;
+    for (int64_t r = 0; r < num_ranges; r++) {
+      range_starts[r] = total;
+      for (int64_t b = 0; b < num_blocks; b++) {
+        SGOffset count = block_counts[b * num_ranges + r];
+        block_counts[b * num_ranges + r] = total;
+        total += count;
+      }
+    }
+    range_starts[num_ranges] = total;
+    EdgeList grouped(total);
+#pragma omp parallel for schedule(static, 1)
+    for (int64_t b = 0; b < num_blocks; b++) {
+      SGOffset *next = block_counts.data() + b * num_ranges;
+      int64_t block_end = std::min(int64_t(el.size()), (b+1) * block_size);
+      for (int64_t i = b * block_size; i < block_end; i++) {
+        Edge e = el[i];
+        if (add_out)
+          grouped[next[e.u >> range_bits]++] = e;
+        if (add_in) {
+          NodeID_ v = static_cast<NodeID_>(e.v);
+          grouped[next[v >> range_bits]++] = Edge(v, GetSource(e));
+        }
+      }
+    }
+    pvector<SGOffset> offsets(num_nodes_ + 1);
+    *neighs = new DestID_[total];
+    NUMAPlace(*neighs, total * sizeof(DestID_));
+    AdviseArray(*neighs, total);
+#pragma omp parallel for schedule(dynamic, 1)
+    for (int64_t r = 0; r < num_ranges; r++) {
+      NodeID_ first = r * range_size;
+      NodeID_ last = std::min(num_nodes_, (r+1) * range_size);
+      pvector<SGOffset> next(last - first, 0);
+      for (SGOffset i = range_starts[r]; i < range_starts[r+1]; i++)
+        next[grouped[i].u - first]++;
+      SGOffset pos = range_starts[r];
+      for (NodeID_ n = first; n < last; n++) {
+        SGOffset degree = next[n - first];
+        offsets[n] = pos;
+        next[n - first] = pos;
+        pos += degree;
+      }
+      for (SGOffset i = range_starts[r]; i < range_starts[r+1]; i++)
+        (*neighs)[next[grouped[i].u - first]++] = grouped[i].v;
+    }
+    offsets[num_nodes_] = total;
+    *index = Index(offsets.data(), num_nodes_, *neighs);
+  }
+
 
-  CSRGraph<NodeID_, DestID_, invert> MakeGraphFromEL(EdgeList &el) {
-    DestID_ **index = nullptr, **inv_index = nullptr;
-    DestID_ *neighs = nullptr, *inv_neighs = nullptr;
+  // If squish, removes self-loops and redundant edges (in place) before
+  // returning graph, which is already done by in-place building, otherwise
+  // sorts neighborhoods if kernel needs them sorted
+  // Inverse of a directed graph is left for the graph to make if needed
+  CSRGraphT MakeGraphFromEL(EdgeList &el, bool squish = false) {
+    Index index;
+    DestID_ *neighs = nullptr;
     Timer t;
     t.Start();
     if (num_nodes_ == -1)
@@ -330,84 +635,453 @@ public:
     if (needs_weights_)
       Generator<NodeID_, DestID_, WeightT_>::InsertWeights(el);
     if (in_place_) {
-      MakeCSRInPlace(el, &index, &neighs, &inv_index, &inv_neighs);
+      MakeCSRInPlace(el, &index, &neighs);
+    } else if (partitioned_) {
+      MakeCSRPartitioned(el, false, &index, &neighs);
     } else {
       MakeCSR(el, false, &index, &neighs);
-      if (!symmetrize_ && invert) {
-        MakeCSR(el, true, &inv_index, &inv_neighs);
-      }
     }
     t.Stop();
+    if (partitioned_ && !in_place_)
+      PrintLabel("Build Algorithm", "partitioned");
     PrintTime("Build Time", t.Seconds());
+    if (squish && !in_place_)
+      SquishCSRInPlace(&index, &neighs);
+    else if (kSort && !in_place_)
+      SortCSR(index);
     if (symmetrize_)
-      return CSRGraph<NodeID_, DestID_, invert>(num_nodes_, index, neighs);
+      return CSRGraphT(num_nodes_, index, neighs);
     else
-      return CSRGraph<NodeID_, DestID_, invert>(num_nodes_, index, neighs,
-                                                inv_index, inv_neighs);
+      return CSRGraphT(num_nodes_, index, neighs, Index(), nullptr);
   }
 
-  CSRGraph<NodeID_, DestID_, invert> MakeGraph() {
-    CSRGraph<NodeID_, DestID_, invert> g;
+  // Runs binary with other ID width instead if input needs it (id_width.h)
+  CSRGraphT MakeGraph() {
+    RunWithIDBytes<NodeID_>(InputIDBytes(cli_), cli_);
+    CSRGraphT g;
+    BuildCache cache = OpenBuildCache();
+    if (cache.Hit()) {
+      g = LoadCached(cache);
+      g.set_sort_inverse(kSort);
+      if constexpr (invert && !lazy_inverse)
+        g.PrepareInverse();
+      PrintNUMAUsage();
+      PlaceTiers(g);
+      return g;
+    }
     { // extra scope to trigger earlier deletion of el (save memory)
       EdgeList el;
       if (cli_.filename() != "") {
-        Reader<NodeID_, DestID_, WeightT_, invert> r(cli_.filename());
+        ReaderT r(cli_.filename());
         if ((r.GetSuffix() == ".sg") || (r.GetSuffix() == ".wsg")) {
-          return r.ReadSerializedGraph();
+          if (cli_.mmap_sg())
+            g = r.MapSerializedGraph();
+          else
+            g = r.ReadSerializedGraph();
+          return FinishGraph(std::move(g), cache);
         } else {
           el = r.ReadFile(needs_weights_);
+          if (r.ids_too_wide())
+            RunWithIDBytes<NodeID_>(sizeof(int64_t), cli_);
         }
       } else if (cli_.scale() != -1) {
         Generator<NodeID_, DestID_> gen(cli_.scale(), cli_.degree());
         el = gen.GenerateEL(cli_.uniform());
       }
-      g = MakeGraphFromEL(el);
+      g = MakeGraphFromEL(el, kSquish);
     }
-    if (in_place_)
-      return g;
-    else
-      return SquishGraph(g);
+    return FinishGraph(std::move(g), cache);
   }
 
-  // Relabels (and rebuilds) graph by order of decreasing degree
-  static CSRGraph<NodeID_, DestID_, invert>
-  RelabelByDegree(const CSRGraph<NodeID_, DestID_, invert> &g) {
-    if (g.directed()) {
-      std::cout << "Cannot relabel directed graph" << std::endl;
-      std::exit(-11);
+  // Makes inverse (unless lazy, relabeling keeps it), reorders (if -R) and
+  // stores in build cache (if -C), then places and reports built or loaded
+  // graph
+  CSRGraphT FinishGraph(CSRGraphT g, const BuildCache &cache) {
+    pvector<NodeID_> new_ids;
+    g.set_sort_inverse(kSort);
+    if constexpr (invert && !lazy_inverse)
+      g.PrepareInverse();
+    if (cli_.reorder_strategy() != ReorderStrategy::kNone) {
+      g = Reorder(g, &new_ids);
+      g.set_sort_inverse(kSort);
     }
+    if (cache.enabled())
+      StoreCached(g, new_ids, cache);
+    PrintNUMAUsage();
+    PlaceTiers(g);
+    return g;
+  }
+
+  // Relabels graph by the ordering chosen with -R, writes the mapping from
+  // original IDs to new ones if -P given
+  CSRGraphT Reorder(const CSRGraphT &g, pvector<NodeID_> *new_ids) {
+    Timer t;
+    t.Start();
+    const DegreeKind kind = cli_.reorder_degree();
+    *new_ids = ComputeOrder<NodeID_>(g, cli_.reorder_strategy(),
+        [&g, kind](NodeID_ n) { return OrderingDegree(g, n, kind); });
+    CSRGraphT reordered = RelabelByMapping(g, *new_ids);
+    t.Stop();
+    PrintLabel("Reordering", cli_.reorder());
+    PrintTime("Reorder Time", t.Seconds());
+    if ((cli_.permutation_file() != "") &&
+        !WritePermutation(*new_ids, cli_.permutation_file())) {
+      std::cout << "Couldn't open file " << cli_.permutation_file()
+                << std::endl;
+      std::exit(-6);
+    }
+    return reordered;
+  }
+
+  // Only graphs the serialized format can hold (32 or 64-bit IDs, any
+  // WeightT_) are cached, entries of directed graphs without inverses don't
+  // have them, so a kernel that needs them makes them (see CSRGraph) when
+  // loading
+  static const bool kCacheable =
+      ((sizeof(NodeID_) == sizeof(int32_t)) ||
+       (sizeof(NodeID_) == sizeof(int64_t))) &&
+      (std::is_same<DestID_, NodeID_>::value ||
+       std::is_same<DestID_, NodeWeight<NodeID_, WeightT_>>::value);
+
+  // Entry for the input file and everything that changes the built graph,
+  // disabled without -C or if the input is already serialized
+  BuildCache OpenBuildCache() const {
+    const std::string &filename = cli_.filename();
+    if (!kCacheable || (cli_.build_cache_dir() == "") || (filename == ""))
+      return BuildCache();
+    const size_t suff_pos = filename.rfind('.');
+    const std::string suffix = suff_pos == std::string::npos ? "" :
+                               filename.substr(suff_pos);
+    if ((suffix == ".sg") || (suffix == ".wsg"))
+      return BuildCache();
+    std::string options = "s=" + std::to_string(symmetrize_) +
+                          ",m=" + std::to_string(in_place_) +
+                          ",w=" + std::to_string(needs_weights_) +
+                          ",dest=" + std::to_string(sizeof(DestID_)) +
+                          ",weight=" + SGWeightName(SGWeightKindOf<WeightT_>(),
+                                                    sizeof(WeightT_)) +
+                          ",squish=" + std::to_string(kSquish) +
+                          ",sort=" + std::to_string(kSort) +
+                          ",R=" + cli_.reorder();
+    return BuildCache(cli_.build_cache_dir(), filename, options,
+                      needs_weights_ ? ".wsg" : ".sg");
+  }
+
+  // Loads cached graph (already reordered if -R), and its reordering if -P
+  CSRGraphT LoadCached(const BuildCache &cache) {
+    ReaderT r(cache.path());
+    CSRGraphT g = cli_.mmap_sg() ?
+        r.MapSerializedGraph() : r.ReadSerializedGraph();
+    PrintLabel("Build Cache", "hit");
+    if ((cli_.reorder_strategy() != ReorderStrategy::kNone) &&
+        (cli_.permutation_file() != "")) {
+      std::error_code ec;
+      std::filesystem::copy_file(cache.permutation_path(),
+          cli_.permutation_file(),
+          std::filesystem::copy_options::overwrite_existing, ec);
+      if (ec) {
+        std::cout << "Couldn't open file " << cli_.permutation_file()
+                  << std::endl;
+        std::exit(-6);
+      }
+    }
+    return g;
+  }
+
+  // Best effort, if the entry can't be written the graph is just not cached,
+  // reordering is committed first, so entries with graphs always have it
+  void StoreCached(CSRGraphT &g,
+                   const pvector<NodeID_> &new_ids, const BuildCache &cache) {
+    if constexpr (kCacheable) {
+      Timer t;
+      t.Start();
+      PrintLabel("Build Cache", "miss");
+      if (!new_ids.empty()) {
+        std::string temp = cache.TempPath(cache.permutation_path());
+        if (!WritePermutation(new_ids, temp) ||
+            !cache.Commit(temp, cache.permutation_path())) {
+          std::cout << "Couldn't write build cache " << cache.path()
+                    << std::endl;
+          return;
+        }
+      }
+      std::string temp = cache.TempPath(cache.path());
+      {
+        std::fstream out(temp, std::ios::out | std::ios::binary);
+        if (!out) {
+          std::cout << "Couldn't write build cache " << cache.path()
+                    << std::endl;
+          return;
+        }
+        WriterT(g).WriteSerializedGraph(out);
+      }
+      if (!cache.Commit(temp, cache.path())) {
+        std::cout << "Couldn't write build cache " << cache.path()
+                  << std::endl;
+        return;
+      }
+      t.Stop();
+      PrintTime("Cache Write Time", t.Seconds());
+    }
+  }
+
+  // Resident memory on each NUMA node, only if a placement policy was given
+  void PrintNUMAUsage() const {
+    if (!NUMAPlacementActive())
+      return;
+    PrintLabel("NUMA Placement", cli_.numa_policy());
+    std::vector<int64_t> node_bytes = NUMANodeBytes();
+    for (size_t node = 0; node < node_bytes.size(); node++)
+      PrintStep("Node " + std::to_string(node) + " MB", node_bytes[node] >> 20);
+  }
+
+  // Moves cold neighbors to the slow tier and makes later allocations prefer
+  // the fast tier, only if tiers were given (-T)
+  template <typename GraphT_>
+  void PlaceTiers(const GraphT_ &g) const {
+    const TierSettings &settings = TierGlobalSettings();
+    if (!settings.enabled)
+      return;
+    Timer t;
+    t.Start();
+    TierPlan plan;
+    if (tier_neighbors_) {
+      plan.Classify(g.num_nodes(), [&g](NodeID_ n) { return g.out_neigh(n); });
+      if constexpr (invert) {
+        if (g.directed() && g.inverse_ready())
+          plan.Classify(g.num_nodes(),
+                        [&g](NodeID_ n) { return g.in_neigh(n); });
+      }
+      plan.Apply();
+    }
+    TierPreferFast();
+    t.Stop();
+    PrintTime("Tiering Time", t.Seconds());
+    PrintStep("Fast Plan MB", plan.hot_bytes() >> 20);
+    PrintStep("Slow Plan MB", plan.cold_bytes() >> 20);
+    PrintStep("Tier Moved MB", plan.moved_bytes() >> 20);
+    if (settings.migrate)
+      plan.StartMigration();
+  }
+
+  // Degree used to order vertices, in and total only differ from out for
+  // directed graphs that have inverses
+  template <typename GraphT_>
+  static int64_t OrderingDegree(const GraphT_ &g, NodeID_ v, DegreeKind kind) {
+    if constexpr (invert) {
+      if (g.directed() && (kind == DegreeKind::kIn))
+        return g.in_degree(v);
+      if (g.directed() && (kind == DegreeKind::kTotal))
+        return g.out_degree(v) + g.in_degree(v);
+    }
+    return g.out_degree(v);
+  }
+
+  // Relabels (and rebuilds) graph by order of decreasing degree
+  template <typename GraphT_>
+  static CSRGraphT RelabelByDegree(
+      const GraphT_ &g, DegreeKind kind = DegreeKind::kOut) {
     Timer t;
     t.Start();
     typedef std::pair<int64_t, NodeID_> degree_node_p;
     pvector<degree_node_p> degree_id_pairs(g.num_nodes());
 #pragma omp parallel for
     for (NodeID_ n = 0; n < g.num_nodes(); n++)
-      degree_id_pairs[n] = std::make_pair(g.out_degree(n), n);
-    std::sort(degree_id_pairs.begin(), degree_id_pairs.end(),
-              std::greater<degree_node_p>());
-    pvector<NodeID_> degrees(g.num_nodes());
+      degree_id_pairs[n] = std::make_pair(OrderingDegree(g, n, kind), n);
+    {
+      // decreasing order of (degree, ID), like std::greater
+      pvector<degree_node_p> temp(g.num_nodes());
+      auto key = [](const degree_node_p &p) {
+        return ~((static_cast<unsigned __int128>(OrderedBits(p.first))
+                  << (8*sizeof(NodeID_))) | OrderedBits(p.second));
+      };
+      ParallelRadixSort(degree_id_pairs.data(), temp.data(), g.num_nodes(),
+                        key);
+    }
     pvector<NodeID_> new_ids(g.num_nodes());
 #pragma omp parallel for
-    for (NodeID_ n = 0; n < g.num_nodes(); n++) {
-      degrees[n] = degree_id_pairs[n].first;
+    for (NodeID_ n = 0; n < g.num_nodes(); n++)
       new_ids[degree_id_pairs[n].second] = n;
+    CSRGraphT relabeled = RelabelByMapping(g, new_ids);
+    t.Stop();
+    PrintTime("Relabel", t.Seconds());
+    return relabeled;
+  }
+
+  // Rebuilds graph with vertex v renamed new_ids[v] (new_ids must be a
+  // permutation), neighborhoods stay sorted (if kernel needs them sorted),
+  // if directed both out and in
+  // neighbors are rebuilt (under the same new IDs), unless the inverse hasn't
+  // been made yet, then the relabeled graph makes its own when needed
+  template <typename GraphT_>
+  static CSRGraphT RelabelByMapping(
+      const GraphT_ &g, const pvector<NodeID_> &new_ids) {
+    Index index;
+    DestID_ *neighs;
+    RelabelNeighs(g.num_nodes(), new_ids,
+                  [&g](NodeID_ n) { return g.out_degree(n); },
+                  [&g](NodeID_ n) { return g.out_neigh(n); }, &index, &neighs);
+    if (!g.directed())
+      return CSRGraphT(g.num_nodes(), index, neighs);
+    Index inv_index;
+    DestID_ *inv_neighs = nullptr;
+    if constexpr (invert) {
+      if (g.inverse_ready())
+        RelabelNeighs(g.num_nodes(), new_ids,
+                      [&g](NodeID_ n) { return g.in_degree(n); },
+                      [&g](NodeID_ n) { return g.in_neigh(n); },
+                      &inv_index, &inv_neighs);
     }
+    return CSRGraphT(g.num_nodes(), index, neighs, inv_index, inv_neighs);
+  }
+
+  // Builds one direction of relabeled CSR from neighborhoods neigh(n)
+  template <typename DegreeFunc, typename NeighFunc>
+  static void RelabelNeighs(int64_t num_nodes, const pvector<NodeID_> &new_ids,
+                            DegreeFunc degree, NeighFunc neigh,
+                            Index *index, DestID_ **neighs) {
+    pvector<NodeID_> degrees(num_nodes);
+#pragma omp parallel for
+    for (NodeID_ n = 0; n < num_nodes; n++)
+      degrees[new_ids[n]] = degree(n);
     pvector<SGOffset> offsets = ParallelPrefixSum(degrees);
-    DestID_ *neighs = new DestID_[offsets[g.num_nodes()]];
-    std::cout << "neighs: " << neighs << " ; "
-              << static_cast<intptr_t>(reinterpret_cast<intptr_t>(neighs))
+    *neighs = new DestID_[offsets[num_nodes]];
+    NUMAPlaceNeighs(*neighs, offsets.data(), num_nodes);
+    AdviseArray(*neighs, offsets[num_nodes]);
+    std::cout << "neighs: " << *neighs << " ; "
+              << static_cast<intptr_t>(reinterpret_cast<intptr_t>(*neighs))
               << "\n"
               << std::flush;
-    DestID_ **index = CSRGraph<NodeID_, DestID_>::GenIndex(offsets, neighs);
+    *index = Index(offsets.data(), num_nodes, *neighs);
 #pragma omp parallel for
-    for (NodeID_ u = 0; u < g.num_nodes(); u++) {
-      for (NodeID_ v : g.out_neigh(u))
-        neighs[offsets[new_ids[u]]++] = new_ids[v];
-      std::sort(index[new_ids[u]], index[new_ids[u] + 1]);
+    for (NodeID_ u = 0; u < num_nodes; u++) {
+      for (DestID_ v : neigh(u))
+        (*neighs)[offsets[new_ids[u]]++] = Rename(v, new_ids);
+      if (kSort)
+        SortNeighborhood((*index)[new_ids[u]], (*index)[new_ids[u] + 1]);
     }
+  }
+
+  static NodeID_ Rename(NodeID_ v, const pvector<NodeID_> &new_ids) {
+    return new_ids[v];
+  }
+
+  static NodeWeight<NodeID_, WeightT_> Rename(
+      const NodeWeight<NodeID_, WeightT_> &v, const pvector<NodeID_> &new_ids) {
+    return NodeWeight<NodeID_, WeightT_>(new_ids[v.v], v.w);
+  }
+};
+
+
+/*
+GAP Benchmark Suite
+Class:  CompressedBuilderBase
+
+Same as BuilderBase, but returns graphs compressed (CompressedCSRGraph)
+ - Graph is built as a CSRGraph and then encoded (in parallel), so building
+   briefly needs both, but only the compressed graph is kept
+ - Always built sorted and squished (whatever the kernel needs), since
+   encoding relies on increasing neighbor IDs to keep gaps small
+ - Used as Builder when compiled with COMPRESSED=1 (benchmark.h)
+*/
+
+template <typename NodeID_, typename WeightT_ = NodeID_,
+          unsigned needs = kNeedsAll>
+class CompressedBuilderBase
+    : public BuilderBase<NodeID_, NodeID_, WeightT_,
+                         needs | kNeedsSorted | kNeedsSquished> {
+  typedef BuilderBase<NodeID_, NodeID_, WeightT_,
+                      needs | kNeedsSorted | kNeedsSquished> Base;
+  static const bool invert =
+      (needs & (kNeedsInverse | kNeedsLazyInverse)) != 0;
+  static const bool lazy_inverse = invert && !(needs & kNeedsInverse);
+  typedef CompressedCSRGraph<NodeID_, invert> CGraph;
+
+public:
+  // Tiers only change where later allocations go, since the CSR neighbors
+  // are replaced by the compressed graph
+  explicit CompressedBuilderBase(const CLBase &cli) : Base(cli) {
+    Base::tier_neighbors_ = false;
+  }
+
+  CGraph MakeGraph() {
+    return Compress(Base::MakeGraph());
+  }
+
+  static CGraph RelabelByDegree(const CGraph &g) {
+    return Compress(Base::RelabelByDegree(g));
+  }
+
+  static CGraph Compress(
+      const CSRGraph<NodeID_, NodeID_, invert, lazy_inverse> &g) {
+    Timer t;
+    t.Start();
+    CGraph cg = CGraph::FromCSR(g);
     t.Stop();
-    PrintTime("Relabel", t.Seconds());
-    return CSRGraph<NodeID_, DestID_, invert>(g.num_nodes(), index, neighs);
+    PrintTime("Compress Time", t.Seconds());
+    PrintStep("Compressed Bytes", cg.encoded_bytes());
+    return cg;
+  }
+};
+
+
+/*
+GAP Benchmark Suite
+Class:  SplitBuilderBase
+
+Same as BuilderBase, but returns weighted graphs with their weights apart
+from their neighbors (SplitCSRGraph)
+ - .wsg inputs already store weights apart, so they are loaded directly
+   (Reader::LoadSplitGraph) unless they need reordering
+ - Otherwise, graph is built as a CSRGraph of NodeWeights and then split in
+   place (in parallel), so building only needs one direction's weights on
+   top of the CSRGraph (see SplitCSRGraph::FromCSR)
+ - Used as WeightedBuilder (benchmark.h)
+*/
+
+template <typename NodeID_, typename WeightT_ = NodeID_,
+          unsigned needs = kNeedsAll>
+class SplitBuilderBase
+    : public BuilderBase<NodeID_, NodeWeight<NodeID_, WeightT_>, WeightT_,
+                         needs> {
+  typedef NodeWeight<NodeID_, WeightT_> WNode;
+  typedef BuilderBase<NodeID_, WNode, WeightT_, needs> Base;
+  static const bool invert =
+      (needs & (kNeedsInverse | kNeedsLazyInverse)) != 0;
+  static const bool lazy_inverse = invert && !(needs & kNeedsInverse);
+  typedef SplitCSRGraph<NodeID_, WeightT_, invert> SGraph;
+
+  const CLBase &cli_;
+
+public:
+  // Tiers only change where later allocations go, since the CSR neighbors
+  // are replaced by the split graph
+  explicit SplitBuilderBase(const CLBase &cli) : Base(cli), cli_(cli) {
+    Base::tier_neighbors_ = false;
+  }
+
+  SGraph MakeGraph() {
+    if ((cli_.reorder_strategy() == ReorderStrategy::kNone) &&
+        (cli_.filename() != "")) {
+      Reader<NodeID_, WNode, WeightT_, invert, lazy_inverse> r(cli_.filename());
+      if (r.GetSuffix() == ".wsg") {
+        RunWithIDBytes<NodeID_>(InputIDBytes(cli_), cli_);
+        SGraph g = r.LoadSplitGraph(cli_.mmap_sg());
+        Base::PrintNUMAUsage();
+        Base::PlaceTiers(g);
+        return g;
+      }
+    }
+    return Split(Base::MakeGraph());
+  }
+
+  static SGraph Split(CSRGraph<NodeID_, WNode, invert, lazy_inverse> &&g) {
+    Timer t;
+    t.Start();
+    SGraph sg = SGraph::FromCSR(std::move(g));
+    t.Stop();
+    PrintTime("Split Time", t.Seconds());
+    return sg;
   }
 };
 
@@ -13,6 +13,7 @@
 #include "builder.h"
 #include "command_line.h"
 #include "graph.h"
+#include "numa_partition.h"
 #include "pvector.h"
 #include "timer.h"
 #include "util.h"
@@ -33,6 +34,9 @@ which restructures and extends the Shiloach-Vishkin algorithm [2].
 
 [2] Yossi Shiloach and Uzi Vishkin. "An o(logn) parallel connectivity algorithm"
     Journal of Algorithms, 3(1):57–67, 1982.
+
+With -N partitioned, each NUMA node's vertices are linked by threads on that
+node (see NUMAPartitions).
 */
 
 
@@ -58,13 +62,12 @@ void Link(NodeID u, NodeID v, pvector<NodeID>& comp) {
 
 
 // Reduce depth of tree for each component to 1 by crawling up parents
-void Compress(const Graph &g, pvector<NodeID>& comp) {
-  #pragma omp parallel for schedule(dynamic, 16384)
-  for (NodeID n = 0; n < g.num_nodes(); n++) {
+void Compress(const NUMAPartitions &parts, pvector<NodeID>& comp) {
+  parts.ForEachLocal([&comp](NodeID n) {
     while (comp[n] != comp[comp[n]]) {
       comp[n] = comp[comp[n]];
     }
-  }
+  }, 16384);
 }
 
 
@@ -94,6 +97,7 @@ NodeID SampleFrequentElement(const pvector<NodeID>& comp,
 
 pvector<NodeID> Afforest(const Graph &g, int32_t neighbor_rounds = 2) {
   pvector<NodeID> comp(g.num_nodes());
+  NUMAPartitions parts(g.num_nodes());
 
   // Initialize each node to a single-node self-pointing tree
   #pragma omp parallel for
@@ -103,15 +107,14 @@ pvector<NodeID> Afforest(const Graph &g, int32_t neighbor_rounds = 2) {
   // Process a sparse sampled subgraph first for approximating components.
   // Sample by processing a fixed number of neighbors for each node (see paper)
   for (int r = 0; r < neighbor_rounds; ++r) {
-  #pragma omp parallel for schedule(dynamic,16384)
-    for (NodeID u = 0; u < g.num_nodes(); u++) {
+    parts.ForEachLocal([&](NodeID u) {
       for (NodeID v : g.out_neigh(u, r)) {
         // Link at most one time if neighbor available at offset r
         Link(u, v, comp);
         break;
       }
-    }
-    Compress(g, comp);
+    }, 16384);
+    Compress(parts, comp);
   }
 
   // Sample 'comp' to find the most frequent element -- due to prior
@@ -120,21 +123,20 @@ pvector<NodeID> Afforest(const Graph &g, int32_t neighbor_rounds = 2) {
 
   // Final 'link' phase over remaining edges (excluding largest component)
   if (!g.directed()) {
-    #pragma omp parallel for schedule(dynamic, 16384)
-    for (NodeID u = 0; u < g.num_nodes(); u++) {
+    parts.ForEachLocal([&](NodeID u) {
       // Skip processing nodes in the largest component
       if (comp[u] == c)
-        continue;
+        return;
       // Skip over part of neighborhood (determined by neighbor_rounds)
       for (NodeID v : g.out_neigh(u, neighbor_rounds)) {
         Link(u, v, comp);
       }
-    }
+    }, 16384);
   } else {
-    #pragma omp parallel for schedule(dynamic, 16384)
-    for (NodeID u = 0; u < g.num_nodes(); u++) {
+    g.PrepareInverse();
+    parts.ForEachLocal([&](NodeID u) {
       if (comp[u] == c)
-        continue;
+        return;
       for (NodeID v : g.out_neigh(u, neighbor_rounds)) {
         Link(u, v, comp);
       }
@@ -142,10 +144,10 @@ pvector<NodeID> Afforest(const Graph &g, int32_t neighbor_rounds = 2) {
       for (NodeID v : g.in_neigh(u)) {
         Link(u, v, comp);
       }
-    }
+    }, 16384);
   }
   // Finally, 'compress' for final convergence
-  Compress(g, comp);
+  Compress(parts, comp);
   return comp;
 }
 
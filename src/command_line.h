@@ -13,6 +13,11 @@
 #include <type_traits>
 #include <vector>
 
+#include "allocator.h"
+#include "memory_tiering.h"
+#include "numa_placement.h"
+#include "reorder.h"
+
 /*
 GAP Benchmark Suite
 Class:  CLBase
@@ -28,7 +33,7 @@ protected:
   int argc_;
   char **argv_;
   std::string name_;
-  std::string get_args_ = "f:g:hk:su:m";
+  std::string get_args_ = "f:g:hk:su:mlB:N:A:T:R:P:C:";
   std::vector<std::string> help_strings_;
 
   int scale_ = -1;
@@ -37,6 +42,16 @@ protected:
   bool symmetrize_ = false;
   bool uniform_ = false;
   bool in_place_ = false;
+  bool mmap_sg_ = false;
+  std::string build_alg_ = "atomic";
+  std::string numa_policy_ = "first-touch";
+  std::string alloc_policy_ = "new";
+  std::string tiers_ = "";
+  std::string reorder_ = "none";
+  ReorderStrategy reorder_strategy_ = ReorderStrategy::kNone;
+  DegreeKind reorder_degree_ = DegreeKind::kOut;
+  std::string permutation_file_ = "";
+  std::string build_cache_dir_ = "";
 
   void AddHelpLine(char opt, std::string opt_arg, std::string text,
                    std::string def = "") {
@@ -62,6 +77,25 @@ public:
     AddHelpLine('k', "degree", "average degree for synthetic graph",
                 std::to_string(degree_));
     AddHelpLine('m', "", "reduces memory usage during graph building", "false");
+    AddHelpLine('l', "", "memory-map serialized graph instead of reading",
+                "false");
+    AddHelpLine('B', "alg", "CSR building algorithm: atomic or partitioned",
+                build_alg_);
+    AddHelpLine('N', "policy",
+                "NUMA placement: interleave, bind[:node], partitioned",
+                numa_policy_);
+    AddHelpLine('A', "alloc",
+                "alloc: thp, huge2m, huge1g, interleave, parallel-touch",
+                alloc_policy_);
+    AddHelpLine('T', "tiers", "memory tiers: fast:slow[:hot_frac][:migrate]",
+                "off");
+    AddHelpLine('R', "order",
+                "reorder: degree, hub-sort, hub-cluster, dbg, rcm, gorder",
+                reorder_);
+    AddHelpLine('R', "ord:deg", "order by out, in, or total degree (directed)",
+                "out");
+    AddHelpLine('P', "file", "write reordering (new ID of each vertex)");
+    AddHelpLine('C', "dir", "cache graphs built from edge lists in dir");
   }
 
   bool ParseArgs() {
@@ -103,6 +137,52 @@ public:
     case 'm':
       in_place_ = true;
       break;
+    case 'l':
+      mmap_sg_ = true;
+      break;
+    case 'B':
+      build_alg_ = std::string(opt_arg);
+      if ((build_alg_ != "atomic") && (build_alg_ != "partitioned")) {
+        std::cout << "Unrecognized building algorithm: " << build_alg_
+                  << std::endl;
+        std::exit(-13);
+      }
+      break;
+    case 'N':
+      numa_policy_ = std::string(opt_arg);
+      if (!ParseNUMAPolicy(numa_policy_, &NUMAGlobalSettings())) {
+        std::cout << "Unrecognized NUMA policy: " << numa_policy_ << std::endl;
+        std::exit(-15);
+      }
+      break;
+    case 'A':
+      alloc_policy_ = std::string(opt_arg);
+      if (!ParseAllocPolicy(alloc_policy_, &AllocGlobalPolicy())) {
+        std::cout << "Unrecognized allocator: " << alloc_policy_ << std::endl;
+        std::exit(-16);
+      }
+      break;
+    case 'T':
+      tiers_ = std::string(opt_arg);
+      if (!ParseTierSpec(tiers_, &TierGlobalSettings())) {
+        std::cout << "Unrecognized memory tiers: " << tiers_ << std::endl;
+        std::exit(-17);
+      }
+      break;
+    case 'R':
+      reorder_ = std::string(opt_arg);
+      if (!ParseReorderStrategy(reorder_, &reorder_strategy_,
+                                &reorder_degree_)) {
+        std::cout << "Unrecognized reordering: " << reorder_ << std::endl;
+        std::exit(-18);
+      }
+      break;
+    case 'P':
+      permutation_file_ = std::string(opt_arg);
+      break;
+    case 'C':
+      build_cache_dir_ = std::string(opt_arg);
+      break;
     }
   }
 
@@ -120,6 +200,17 @@ public:
   bool symmetrize() const { return symmetrize_; }
   bool uniform() const { return uniform_; }
   bool in_place() const { return in_place_; }
+  bool mmap_sg() const { return mmap_sg_; }
+  std::string build_alg() const { return build_alg_; }
+  std::string numa_policy() const { return numa_policy_; }
+  std::string alloc_policy() const { return alloc_policy_; }
+  std::string tiers() const { return tiers_; }
+  std::string reorder() const { return reorder_; }
+  ReorderStrategy reorder_strategy() const { return reorder_strategy_; }
+  DegreeKind reorder_degree() const { return reorder_degree_; }
+  std::string permutation_file() const { return permutation_file_; }
+  std::string build_cache_dir() const { return build_cache_dir_; }
+  char** argv() const { return argv_; }
 };
 
 class CLApp : public CLBase {
@@ -258,14 +349,18 @@ class CLConvert : public CLBase {
   bool out_weighted_ = false;
   bool out_el_ = false;
   bool out_sg_ = false;
+  bool out_checksums_ = false;
+  bool out_compressed_ = false;
 
 public:
   CLConvert(int argc, char **argv, std::string name)
       : CLBase(argc, argv, name) {
-    get_args_ += "e:b:w";
+    get_args_ += "e:b:wcz";
     AddHelpLine('b', "file", "output serialized graph to file");
-    AddHelpLine('e', "file", "output edge list to file");
+    AddHelpLine('e', "file", "output edge list to file (binary if .bel/.bwel)");
     AddHelpLine('w', "file", "make output weighted");
+    AddHelpLine('c', "", "add checksums to serialized graph", "false");
+    AddHelpLine('z', "", "compress neighbors of serialized graph", "false");
   }
 
   void HandleArg(signed char opt, char *opt_arg) override {
@@ -281,6 +376,12 @@ public:
     case 'w':
       out_weighted_ = true;
       break;
+    case 'c':
+      out_checksums_ = true;
+      break;
+    case 'z':
+      out_compressed_ = true;
+      break;
     default:
       CLBase::HandleArg(opt, opt_arg);
     }
@@ -290,6 +391,8 @@ public:
   bool out_weighted() const { return out_weighted_; }
   bool out_el() const { return out_el_; }
   bool out_sg() const { return out_sg_; }
+  bool out_checksums() const { return out_checksums_; }
+  bool out_compressed() const { return out_compressed_; }
 };
 
 #endif // COMMAND_LINE_H_
@@ -0,0 +1,245 @@
+// Copyright (c) 2015, The Regents of the University of California (Regents)
+// See LICENSE.txt for license details
+
+#ifndef COMPRESSED_FILE_H_
+#define COMPRESSED_FILE_H_
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <climits>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef GAPBS_ZSTD
+  #include <zstd.h>
+#endif
+
+
+/*
+GAP Benchmark Suite
+Class:  CompressedFile
+
+Streams the decompressed contents of a gzip (.gz) or zstd (.zst) file as a
+sequence of blocks of whole lines, so text formats can be parsed without the
+decompressed file ever being stored (on disk or in memory) all at once
+ - A background thread decompresses into one buffer while the caller parses
+   the block in the other, so decompression overlaps with parsing
+ - Every block ends with a newline except possibly the last, the partial line
+   at the end of a buffer is carried over to the start of the next block
+ - There is always at least one block (maybe empty), so headers can be parsed
+   from the first block
+ - zstd requires building with ZSTD=1 (see Makefile)
+*/
+
+
+class CompressedFile {
+ public:
+  static bool IsCompressedSuffix(std::string suffix) {
+    return (suffix == ".gz") || (suffix == ".zst");
+  }
+
+  explicit CompressedFile(std::string filename,
+                          size_t block_bytes = size_t(1) << 26)
+      : filename_(filename),
+        zstd_((filename.size() > 4) &&
+              (filename.compare(filename.size() - 4, 4, ".zst") == 0)) {
+    if (zstd_) {
+      #ifdef GAPBS_ZSTD
+        zst_file_ = std::fopen(filename.c_str(), "rb");
+        if (zst_file_ == nullptr)
+          ExitCouldntOpen();
+        zst_stream_ = ZSTD_createDStream();
+        ZSTD_initDStream(zst_stream_);
+        zst_in_buf_.resize(ZSTD_DStreamInSize());
+        zst_in_ = {zst_in_buf_.data(), 0, 0};
+      #else
+        std::cout << "Reading .zst requires building with ZSTD=1" << std::endl;
+        std::exit(-28);
+      #endif
+    } else {
+      gz_file_ = gzopen(filename.c_str(), "rb");
+      if (gz_file_ == nullptr)
+        ExitCouldntOpen();
+      gzbuffer(gz_file_, 1 << 20);
+    }
+    for (int b = 0; b < 2; b++) {
+      buffers_[b].resize(block_bytes);
+      free_.push_back(b);
+    }
+    decompressor_ = std::thread(&CompressedFile::Decompress, this);
+  }
+
+  // don't want this to be copied, thread refers to this instance
+  CompressedFile(const CompressedFile &other) = delete;
+  CompressedFile& operator=(const CompressedFile &other) = delete;
+
+  ~CompressedFile() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+    }
+    ready_.notify_all();
+    decompressor_.join();
+    if (gz_file_ != nullptr)
+      gzclose(gz_file_);
+    #ifdef GAPBS_ZSTD
+      if (zst_stream_ != nullptr)
+        ZSTD_freeDStream(zst_stream_);
+      if (zst_file_ != nullptr)
+        std::fclose(zst_file_);
+    #endif
+  }
+
+  // Returns false once all blocks have been returned, otherwise sets
+  // [begin, end) to next block, which stays valid until the next call
+  bool NextBlock(const char **begin, const char **end) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (current_ != -1) {
+      free_.push_back(current_);
+      current_ = -1;
+      ready_.notify_all();
+    }
+    ready_.wait(lock, [this] { return !full_.empty(); });
+    int b = full_.front();
+    full_.pop_front();
+    if (b == kEndOfFile)
+      return false;
+    current_ = b;
+    *begin = buffers_[b].data();
+    *end = *begin + lengths_[b];
+    return true;
+  }
+
+ private:
+  static constexpr int kEndOfFile = -1;
+
+  void ExitCouldntOpen() {
+    std::cout << "Couldn't open file " << filename_ << std::endl;
+    std::exit(-6);
+  }
+
+  void ExitCorrupt() {
+    std::cout << "Couldn't decompress " << filename_ << std::endl;
+    std::exit(-28);
+  }
+
+  // Decompresses up to max_bytes into dest, returns 0 only at end of file
+  size_t Read(char *dest, size_t max_bytes) {
+    if (zstd_)
+      return ReadZstd(dest, max_bytes);
+    int to_read = static_cast<int>(std::min(max_bytes, size_t(INT_MAX)));
+    int bytes_read = gzread(gz_file_, dest, to_read);
+    int error = Z_OK;
+    if (bytes_read <= 0)
+      gzerror(gz_file_, &error);  // Z_BUF_ERROR if file was truncated
+    if ((bytes_read < 0) || (error != Z_OK))
+      ExitCorrupt();
+    return bytes_read;
+  }
+
+  size_t ReadZstd(char *dest, size_t max_bytes) {
+    #ifdef GAPBS_ZSTD
+      ZSTD_outBuffer out = {dest, max_bytes, 0};
+      while (out.pos < out.size) {
+        if (zst_in_.pos == zst_in_.size) {
+          zst_in_.size = std::fread(zst_in_buf_.data(), 1, zst_in_buf_.size(),
+                                    zst_file_);
+          zst_in_.pos = 0;
+          if (zst_in_.size == 0) {
+            // file ended in the middle of a frame
+            if (zst_frame_remaining_ != 0)
+              ExitCorrupt();
+            break;
+          }
+        }
+        zst_frame_remaining_ = ZSTD_decompressStream(zst_stream_, &out,
+                                                     &zst_in_);
+        if (ZSTD_isError(zst_frame_remaining_))
+          ExitCorrupt();
+      }
+      return out.pos;
+    #else
+      return 0;
+    #endif
+  }
+
+  // Runs on background thread, fills free buffers with blocks of whole lines
+  void Decompress() {
+    std::string carry;
+    bool at_eof = false;
+    while (!at_eof) {
+      int b;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        ready_.wait(lock, [this] { return !free_.empty() || stopping_; });
+        if (stopping_)
+          return;
+        b = free_.front();
+        free_.pop_front();
+      }
+      std::vector<char> &buffer = buffers_[b];
+      if (buffer.size() < 2 * carry.size())
+        buffer.resize(2 * carry.size());
+      std::copy(carry.begin(), carry.end(), buffer.begin());
+      size_t filled = carry.size();
+      size_t block_end;
+      while (true) {
+        if (filled == buffer.size())
+          buffer.resize(2 * buffer.size());  // line longer than buffer
+        size_t bytes_read = Read(buffer.data() + filled,
+                                 buffer.size() - filled);
+        filled += bytes_read;
+        if (bytes_read == 0) {
+          at_eof = true;
+          block_end = filled;
+          break;
+        }
+        if (filled == buffer.size()) {
+          const void *last_newline = memrchr(buffer.data(), '\n', filled);
+          if (last_newline != nullptr) {
+            block_end = static_cast<const char*>(last_newline) -
+                        buffer.data() + 1;
+            break;
+          }
+        }
+      }
+      carry.assign(buffer.data() + block_end, buffer.data() + filled);
+      std::lock_guard<std::mutex> lock(mutex_);
+      lengths_[b] = block_end;
+      full_.push_back(b);
+      if (at_eof)
+        full_.push_back(kEndOfFile);
+      ready_.notify_all();
+    }
+  }
+
+  std::string filename_;
+  bool zstd_;
+  gzFile gz_file_ = nullptr;
+  #ifdef GAPBS_ZSTD
+    std::FILE *zst_file_ = nullptr;
+    ZSTD_DStream *zst_stream_ = nullptr;
+    std::vector<char> zst_in_buf_;
+    ZSTD_inBuffer zst_in_;
+    size_t zst_frame_remaining_ = 0;
+  #endif
+  std::vector<char> buffers_[2];
+  size_t lengths_[2] = {0, 0};
+  std::deque<int> free_, full_;
+  int current_ = -1;
+  bool stopping_ = false;
+  std::mutex mutex_;
+  std::condition_variable ready_;
+  std::thread decompressor_;
+};
+
+#endif  // COMPRESSED_FILE_H_
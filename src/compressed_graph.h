@@ -0,0 +1,444 @@
+// Copyright (c) 2015, The Regents of the University of California (Regents)
+// See LICENSE.txt for license details
+
+#ifndef COMPRESSED_GRAPH_H_
+#define COMPRESSED_GRAPH_H_
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstddef>
+#include <iostream>
+#include <iterator>
+#include <type_traits>
+
+#include "graph.h"
+#include "pvector.h"
+#include "util.h"
+
+
+/*
+GAP Benchmark Suite
+Class:  CompressedCSRGraph
+
+Unweighted CSR graph whose neighborhoods are difference encoded into bytes
+(like Ligra+), so it takes far less memory than CSRGraph
+ - Each vertex's bytes are its degree, its first neighbor relative to itself
+   (zigzag, so it can be negative), then the differences between consecutive
+   neighbors, all as varints (7 bits per byte, high bit set if more follow)
+ - Sorted neighborhoods (as built by Builder) have small differences, most
+   of which fit in a byte, but any order of neighbors round trips
+ - Neighborhood iterators decode on the fly, so kernels written for CSRGraph
+   work on it unmodified (build with COMPRESSED=1 to make it Graph)
+ - Index is byte offsets (SGOffset), so out_degree is a single decode
+ - Made from a CSRGraph with FromCSR, which encodes vertices in parallel
+*/
+
+
+inline size_t VarintBytes(uint64_t x) {
+  size_t num_bytes = 1;
+  while (x >= 0x80) {
+    x >>= 7;
+    num_bytes++;
+  }
+  return num_bytes;
+}
+
+inline uint8_t* EncodeVarint(uint64_t x, uint8_t *out) {
+  while (x >= 0x80) {
+    *out++ = static_cast<uint8_t>(x) | 0x80;
+    x >>= 7;
+  }
+  *out++ = static_cast<uint8_t>(x);
+  return out;
+}
+
+// Advances p past decoded varint
+inline uint64_t DecodeVarint(const uint8_t *&p) {
+  uint64_t x = *p++;
+  if (x < 0x80)
+    return x;
+  x &= 0x7f;
+  int shift = 7;
+  uint64_t byte;
+  do {
+    byte = *p++;
+    x |= (byte & 0x7f) << shift;
+    shift += 7;
+  } while (byte >= 0x80);
+  return x;
+}
+
+inline uint64_t ZigZag(int64_t x) {
+  return (static_cast<uint64_t>(x) << 1) ^ static_cast<uint64_t>(x >> 63);
+}
+
+inline int64_t UnZigZag(uint64_t x) {
+  return static_cast<int64_t>(x >> 1) ^ -static_cast<int64_t>(x & 1);
+}
+
+
+template <class NodeID_, bool MakeInverse = true>
+class CompressedCSRGraph {
+  // Used for *non-negative* offsets within a neighborhood
+  typedef std::make_unsigned<std::ptrdiff_t>::type OffsetT;
+
+ public:
+  // new[]'d (see NewAllocator), so graph can take over their storage
+  typedef pvector<SGOffset, NewAllocator<SGOffset>> OffsetVector;
+  typedef pvector<uint8_t, NewAllocator<uint8_t>> ByteVector;
+
+  class iterator {
+   public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef NodeID_ value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const NodeID_* pointer;
+    typedef const NodeID_& reference;
+
+    iterator() : pos_(nullptr), current_(0), remaining_(0) {}
+
+    // pos is just past encoded degree of vertex n
+    iterator(const uint8_t *pos, NodeID_ n, int64_t degree)
+        : pos_(pos), current_(n), remaining_(degree) {
+      if (remaining_ > 0)
+        current_ = static_cast<NodeID_>(n + UnZigZag(DecodeVarint(pos_)));
+    }
+
+    reference operator*() const { return current_; }
+
+    iterator& operator++() {
+      // differences wrap around (mod 2^64) if neighborhood wasn't sorted
+      if (--remaining_ > 0)
+        current_ = static_cast<NodeID_>(static_cast<uint64_t>(current_) +
+                                        DecodeVarint(pos_));
+      return *this;
+    }
+
+    iterator operator++(int) {
+      iterator old = *this;
+      ++(*this);
+      return old;
+    }
+
+    // only meaningful for iterators of the same neighborhood
+    bool operator==(const iterator &other) const {
+      return remaining_ == other.remaining_;
+    }
+
+    bool operator!=(const iterator &other) const {
+      return remaining_ != other.remaining_;
+    }
+
+   private:
+    const uint8_t *pos_;
+    NodeID_ current_;
+    int64_t remaining_;
+  };
+
+  // Used to access neighbors of vertex, basically sugar for iterators
+  class Neighborhood {
+    iterator begin_;
+
+   public:
+    Neighborhood(NodeID_ n, const uint8_t *encoded, OffsetT start_offset) {
+      int64_t degree = DecodeVarint(encoded);
+      begin_ = iterator(encoded, n, degree);
+      start_offset = std::min(start_offset, static_cast<OffsetT>(degree));
+      for (OffsetT i = 0; i < start_offset; i++)
+        ++begin_;
+    }
+    iterator begin() { return begin_; }
+    iterator end() { return iterator(); }
+  };
+
+  // Bytes needed to encode neighborhood [begin, end) of n
+  template <typename IterT>
+  static size_t EncodedBytes(NodeID_ n, IterT begin, IterT end) {
+    size_t num_bytes = VarintBytes(std::distance(begin, end));
+    int64_t prev = n;
+    for (IterT it = begin; it != end; it++) {
+      int64_t v = static_cast<NodeID_>(*it);
+      if (it == begin)
+        num_bytes += VarintBytes(ZigZag(v - prev));
+      else
+        num_bytes += VarintBytes(static_cast<uint64_t>(v - prev));
+      prev = v;
+    }
+    return num_bytes;
+  }
+
+  // Encodes neighborhood [begin, end) of n to out, returns position after it
+  template <typename IterT>
+  static uint8_t* Encode(NodeID_ n, IterT begin, IterT end, uint8_t *out) {
+    out = EncodeVarint(std::distance(begin, end), out);
+    int64_t prev = n;
+    for (IterT it = begin; it != end; it++) {
+      int64_t v = static_cast<NodeID_>(*it);
+      if (it == begin)
+        out = EncodeVarint(ZigZag(v - prev), out);
+      else
+        out = EncodeVarint(static_cast<uint64_t>(v - prev), out);
+      prev = v;
+    }
+    return out;
+  }
+
+  /*
+  Encodes every neighborhood neigh(n) (e.g. out or in of a graph) in parallel
+    - sizes of all vertices are found first (in parallel)
+    - a prefix sum over blocks of vertices gives byte offsets
+    - every vertex then encodes straight to its offset
+  */
+  template <typename NeighFunc>
+  static void EncodeNeighborhoods(int64_t num_nodes, NeighFunc neigh,
+                                  OffsetVector &byte_offsets,
+                                  ByteVector &bytes) {
+    byte_offsets.resize(num_nodes + 1);
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for (NodeID_ n = 0; n < num_nodes; n++) {
+      auto neighs = neigh(n);
+      byte_offsets[n] = EncodedBytes(n, neighs.begin(), neighs.end());
+    }
+    const int64_t block_size = 1 << 20;
+    const int64_t num_blocks = (num_nodes + block_size - 1) / block_size;
+    pvector<SGOffset> block_starts(num_blocks);
+    #pragma omp parallel for
+    for (int64_t b = 0; b < num_blocks; b++) {
+      SGOffset block_total = 0;
+      for (int64_t n = b * block_size;
+           n < std::min(num_nodes, (b + 1) * block_size); n++)
+        block_total += byte_offsets[n];
+      block_starts[b] = block_total;
+    }
+    SGOffset total = 0;
+    for (int64_t b = 0; b < num_blocks; b++) {
+      SGOffset block_total = block_starts[b];
+      block_starts[b] = total;
+      total += block_total;
+    }
+    #pragma omp parallel for
+    for (int64_t b = 0; b < num_blocks; b++) {
+      SGOffset pos = block_starts[b];
+      for (int64_t n = b * block_size;
+           n < std::min(num_nodes, (b + 1) * block_size); n++) {
+        SGOffset vertex_bytes = byte_offsets[n];
+        byte_offsets[n] = pos;
+        pos += vertex_bytes;
+      }
+    }
+    byte_offsets[num_nodes] = total;
+    bytes.resize(total);
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for (NodeID_ n = 0; n < num_nodes; n++) {
+      auto neighs = neigh(n);
+      Encode(n, neighs.begin(), neighs.end(), bytes.data() + byte_offsets[n]);
+    }
+  }
+
+  // Decodes every neighborhood into neighs (at offsets) in parallel, returns
+  // false if any degree doesn't match offsets
+  static bool DecodeNeighborhoods(int64_t num_nodes,
+                                  const SGOffset *byte_offsets,
+                                  const uint8_t *bytes,
+                                  const SGOffset *offsets, NodeID_ *neighs) {
+    bool consistent = true;
+    #pragma omp parallel for schedule(dynamic, 1024) reduction(&& : consistent)
+    for (NodeID_ n = 0; n < num_nodes; n++) {
+      const uint8_t *pos = bytes + byte_offsets[n];
+      int64_t degree = DecodeVarint(pos);
+      if (degree != offsets[n + 1] - offsets[n]) {
+        consistent = false;
+        continue;
+      }
+      std::copy(iterator(pos, n, degree), iterator(), neighs + offsets[n]);
+    }
+    return consistent;
+  }
+
+  template <typename CSRGraphT_>
+  static CompressedCSRGraph FromCSR(const CSRGraphT_ &g) {
+    OffsetVector out_offsets, in_offsets;
+    ByteVector out_bytes, in_bytes;
+    EncodeNeighborhoods(g.num_nodes(),
+                        [&g](NodeID_ n) { return g.out_neigh(n); },
+                        out_offsets, out_bytes);
+    if (!g.directed()) {
+      CompressedCSRGraph cg(g.num_nodes(), out_offsets.data(),
+                            out_bytes.data());
+      out_offsets.leak();
+      out_bytes.leak();
+      return cg;
+    }
+    if constexpr (MakeInverse) {
+      EncodeNeighborhoods(g.num_nodes(),
+                          [&g](NodeID_ n) { return g.in_neigh(n); },
+                          in_offsets, in_bytes);
+    }
+    CompressedCSRGraph cg(g.num_nodes(), out_offsets.data(), out_bytes.data(),
+                          in_offsets.data(), in_bytes.data());
+    out_offsets.leak();
+    out_bytes.leak();
+    in_offsets.leak();
+    in_bytes.leak();
+    return cg;
+  }
+
+  CompressedCSRGraph()
+      : directed_(false), num_nodes_(-1), num_edges_(-1),
+        out_offsets_(nullptr), out_bytes_(nullptr), in_offsets_(nullptr),
+        in_bytes_(nullptr) {}
+
+  // Takes ownership of (new[]'d) byte offsets and bytes
+  CompressedCSRGraph(int64_t num_nodes, SGOffset *offsets, uint8_t *bytes)
+      : directed_(false), num_nodes_(num_nodes), out_offsets_(offsets),
+        out_bytes_(bytes), in_offsets_(offsets), in_bytes_(bytes) {
+    num_edges_ = CountEdges() / 2;
+  }
+
+  CompressedCSRGraph(int64_t num_nodes, SGOffset *out_offsets,
+                     uint8_t *out_bytes, SGOffset *in_offsets,
+                     uint8_t *in_bytes)
+      : directed_(true), num_nodes_(num_nodes), out_offsets_(out_offsets),
+        out_bytes_(out_bytes), in_offsets_(in_offsets), in_bytes_(in_bytes) {
+    num_edges_ = CountEdges();
+  }
+
+  CompressedCSRGraph(CompressedCSRGraph &&other)
+      : directed_(other.directed_), num_nodes_(other.num_nodes_),
+        num_edges_(other.num_edges_), out_offsets_(other.out_offsets_),
+        out_bytes_(other.out_bytes_), in_offsets_(other.in_offsets_),
+        in_bytes_(other.in_bytes_) {
+    other.num_edges_ = -1;
+    other.num_nodes_ = -1;
+    other.out_offsets_ = nullptr;
+    other.out_bytes_ = nullptr;
+    other.in_offsets_ = nullptr;
+    other.in_bytes_ = nullptr;
+  }
+
+  ~CompressedCSRGraph() { ReleaseResources(); }
+
+  CompressedCSRGraph& operator=(CompressedCSRGraph &&other) {
+    if (this != &other) {
+      ReleaseResources();
+      directed_ = other.directed_;
+      num_edges_ = other.num_edges_;
+      num_nodes_ = other.num_nodes_;
+      out_offsets_ = other.out_offsets_;
+      out_bytes_ = other.out_bytes_;
+      in_offsets_ = other.in_offsets_;
+      in_bytes_ = other.in_bytes_;
+      other.num_edges_ = -1;
+      other.num_nodes_ = -1;
+      other.out_offsets_ = nullptr;
+      other.out_bytes_ = nullptr;
+      other.in_offsets_ = nullptr;
+      other.in_bytes_ = nullptr;
+    }
+    return *this;
+  }
+
+  bool directed() const { return directed_; }
+
+  int64_t num_nodes() const { return num_nodes_; }
+
+  int64_t num_edges() const { return num_edges_; }
+
+  int64_t num_edges_directed() const {
+    return directed_ ? num_edges_ : 2 * num_edges_;
+  }
+
+  int64_t out_degree(NodeID_ v) const {
+    const uint8_t *pos = out_bytes_ + out_offsets_[v];
+    return DecodeVarint(pos);
+  }
+
+  int64_t in_degree(NodeID_ v) const {
+    static_assert(MakeInverse, "Graph inversion disabled but reading inverse");
+    const uint8_t *pos = in_bytes_ + in_offsets_[v];
+    return DecodeVarint(pos);
+  }
+
+  Neighborhood out_neigh(NodeID_ n, OffsetT start_offset = 0) const {
+    return Neighborhood(n, out_bytes_ + out_offsets_[n], start_offset);
+  }
+
+  Neighborhood in_neigh(NodeID_ n, OffsetT start_offset = 0) const {
+    static_assert(MakeInverse, "Graph inversion disabled but reading inverse");
+    return Neighborhood(n, in_bytes_ + in_offsets_[n], start_offset);
+  }
+
+  // Inverse is always encoded along with the graph (same interface as CSR)
+  int64_t prepared_in_degree(NodeID_ v) const { return in_degree(v); }
+
+  Neighborhood prepared_in_neigh(NodeID_ n, OffsetT start_offset = 0) const {
+    return in_neigh(n, start_offset);
+  }
+
+  void PrepareInverse() const {
+    static_assert(MakeInverse, "Graph inversion disabled but reading inverse");
+  }
+
+  bool inverse_ready() const { return true; }
+
+  // Bytes of encoded neighborhoods (both directions if directed)
+  int64_t encoded_bytes() const {
+    int64_t total = out_offsets_[num_nodes_];
+    if (directed_ && (in_offsets_ != nullptr))
+      total += in_offsets_[num_nodes_];
+    return total;
+  }
+
+  void PrintStats() const {
+    std::cout << "Graph has " << num_nodes_ << " nodes and " << num_edges_
+              << " ";
+    if (!directed_)
+      std::cout << "un";
+    std::cout << "directed edges for degree: ";
+    std::cout << num_edges_ / num_nodes_ << "\n" << std::flush;
+  }
+
+  void PrintTopology() const {
+    for (NodeID_ i = 0; i < num_nodes_; i++) {
+      std::cout << i << ": ";
+      for (NodeID_ j : out_neigh(i)) {
+        std::cout << j << " ";
+      }
+      std::cout << std::endl;
+    }
+  }
+
+  Range<NodeID_> vertices() const { return Range<NodeID_>(num_nodes()); }
+
+ private:
+  void ReleaseResources() {
+    if (out_offsets_ != nullptr)
+      delete[] out_offsets_;
+    if (out_bytes_ != nullptr)
+      delete[] out_bytes_;
+    if (directed_) {
+      if (in_offsets_ != nullptr)
+        delete[] in_offsets_;
+      if (in_bytes_ != nullptr)
+        delete[] in_bytes_;
+    }
+  }
+
+  int64_t CountEdges() const {
+    int64_t total = 0;
+    #pragma omp parallel for reduction(+ : total)
+    for (NodeID_ n = 0; n < num_nodes_; n++)
+      total += out_degree(n);
+    return total;
+  }
+
+  bool directed_;
+  int64_t num_nodes_;
+  int64_t num_edges_;
+  SGOffset *out_offsets_;
+  uint8_t *out_bytes_;
+  SGOffset *in_offsets_;
+  uint8_t *in_bytes_;
+};
+
+#endif  // COMPRESSED_GRAPH_H_
@@ -16,17 +16,21 @@ int main(int argc, char* argv[]) {
   CLConvert cli(argc, argv, "converter");
   cli.ParseArgs();
   if (cli.out_weighted()) {
-    WeightedBuilder bw(cli);
-    WGraph wg = bw.MakeGraph();
+    // interleaved in memory (even though WGraph splits weights out)
+    BuilderBase<NodeID, WNode, WeightT> bw(cli);
+    CSRGraph<NodeID, WNode> wg = bw.MakeGraph();
     wg.PrintStats();
     WeightedWriter ww(wg);
-    ww.WriteGraph(cli.out_filename(), cli.out_sg());
+    ww.WriteGraph(cli.out_filename(), cli.out_sg(), cli.out_checksums(),
+                  cli.out_compressed());
   } else {
-    Builder b(cli);
-    Graph g = b.MakeGraph();
+    // always uncompressed in memory (even if Graph is compressed)
+    BuilderBase<NodeID, NodeID, WeightT> b(cli);
+    CSRGraph<NodeID> g = b.MakeGraph();
     g.PrintStats();
     Writer w(g);
-    w.WriteGraph(cli.out_filename(), cli.out_sg());
+    w.WriteGraph(cli.out_filename(), cli.out_sg(), cli.out_checksums(),
+                 cli.out_compressed());
   }
   return 0;
 }
@@ -0,0 +1,178 @@
+// Copyright (c) 2015, The Regents of the University of California (Regents)
+// See LICENSE.txt for license details
+
+#ifndef CSR_INDEX_H_
+#define CSR_INDEX_H_
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstddef>
+#include <iostream>
+
+#include "numa_placement.h"
+
+
+/*
+GAP Benchmark Suite
+File:   CSR Index
+
+Indices CSRGraph can use to find where each vertex's neighbors start
+ - index[n] is a pointer to the first neighbor of vertex n (index[n+1] is one
+   past its last), all of them are only ever used through that operator
+ - PointerIndex is the original array of pointers (8 bytes per vertex)
+ - OffsetIndex holds 64-bit offsets from the start of the neighbors, so it
+   doesn't depend on where the neighbors are placed (same as .sg offsets),
+   it's the same size as PointerIndex, but it can use offsets in place (e.g.
+   a memory-mapped .sg file's) without any index memory of its own
+ - BlockOffsetIndex holds 32-bit offsets relative to a 64-bit base per block
+   of vertices (about 4 bytes per vertex, half of the others), blocks are
+   made smaller for graphs whose blocks would span more than 2^32 neighbors
+ - All are made directly from the neighborhoods' offsets (num_nodes+1 of
+   them), which are only read while constructing, unless offsets_in_place
+   and the index is an OffsetIndex, then they must outlive it
+ - Freed explicitly by the graph (Release), since copies share storage
+ - Choose index at build time, e.g. make INDEX=offset (see Makefile)
+*/
+
+
+template <typename DestID_>
+class PointerIndex {
+ public:
+  PointerIndex() : index_(nullptr) {}
+
+  PointerIndex(const int64_t *offsets, int64_t num_nodes, DestID_ *neighs,
+               bool offsets_in_place = false)
+      : index_(new DestID_*[num_nodes + 1]) {
+    NUMAPlace(index_, (num_nodes + 1) * sizeof(DestID_*));
+    std::cout << "index: " << *index_ << " ; "
+              << static_cast<intptr_t>(reinterpret_cast<intptr_t>(*index_))
+              << "\n"
+              << std::flush;
+    #pragma omp parallel for
+    for (int64_t n = 0; n < num_nodes + 1; n++)
+      index_[n] = neighs + offsets[n];
+  }
+
+  DestID_* operator[](int64_t n) const { return index_[n]; }
+
+  bool empty() const { return index_ == nullptr; }
+
+  void Release() {
+    if (index_ != nullptr)
+      delete[] index_;
+    index_ = nullptr;
+  }
+
+ private:
+  DestID_ **index_;
+};
+
+
+template <typename DestID_>
+class OffsetIndex {
+ public:
+  OffsetIndex() : neighs_(nullptr), offsets_(nullptr), owns_offsets_(false) {}
+
+  OffsetIndex(const int64_t *offsets, int64_t num_nodes, DestID_ *neighs,
+              bool offsets_in_place = false)
+      : neighs_(neighs), offsets_(offsets), owns_offsets_(!offsets_in_place) {
+    if (offsets_in_place)
+      return;
+    int64_t *copy = new int64_t[num_nodes + 1];
+    NUMAPlace(copy, (num_nodes + 1) * sizeof(int64_t));
+    #pragma omp parallel for
+    for (int64_t n = 0; n < num_nodes + 1; n++)
+      copy[n] = offsets[n];
+    offsets_ = copy;
+  }
+
+  DestID_* operator[](int64_t n) const { return neighs_ + offsets_[n]; }
+
+  bool empty() const { return offsets_ == nullptr; }
+
+  void Release() {
+    if (owns_offsets_ && (offsets_ != nullptr))
+      delete[] offsets_;
+    offsets_ = nullptr;
+  }
+
+ private:
+  DestID_ *neighs_;
+  const int64_t *offsets_;
+  bool owns_offsets_;
+};
+
+
+template <typename DestID_>
+class BlockOffsetIndex {
+ public:
+  BlockOffsetIndex()
+      : neighs_(nullptr), bases_(nullptr), rel_offsets_(nullptr),
+        block_bits_(0) {}
+
+  BlockOffsetIndex(const int64_t *offsets, int64_t num_nodes, DestID_ *neighs,
+                   bool offsets_in_place = false)
+      : neighs_(neighs), block_bits_(kMaxBlockBits) {
+    const int64_t length = num_nodes + 1;
+    // largest block size where no block spans too many neighbors
+    while ((block_bits_ > 0) && (MaxBlockSpan(offsets, length) > UINT32_MAX))
+      block_bits_--;
+    const int64_t num_blocks = ((length - 1) >> block_bits_) + 1;
+    bases_ = new int64_t[num_blocks];
+    rel_offsets_ = new uint32_t[length];
+    NUMAPlace(rel_offsets_, length * sizeof(uint32_t));
+    #pragma omp parallel for
+    for (int64_t b = 0; b < num_blocks; b++)
+      bases_[b] = offsets[b << block_bits_];
+    #pragma omp parallel for
+    for (int64_t n = 0; n < length; n++)
+      rel_offsets_[n] = offsets[n] - bases_[n >> block_bits_];
+  }
+
+  DestID_* operator[](int64_t n) const {
+    return neighs_ + bases_[n >> block_bits_] + rel_offsets_[n];
+  }
+
+  bool empty() const { return rel_offsets_ == nullptr; }
+
+  void Release() {
+    if (bases_ != nullptr)
+      delete[] bases_;
+    if (rel_offsets_ != nullptr)
+      delete[] rel_offsets_;
+    bases_ = nullptr;
+    rel_offsets_ = nullptr;
+  }
+
+ private:
+  static const int kMaxBlockBits = 16;
+
+  // Most neighbors between the start of a block and one of its vertices
+  int64_t MaxBlockSpan(const int64_t *offsets, int64_t length) const {
+    int64_t max_span = 0;
+    #pragma omp parallel for reduction(max : max_span)
+    for (int64_t n = 0; n < length; n++)
+      max_span = std::max(max_span, offsets[n] -
+                          offsets[(n >> block_bits_) << block_bits_]);
+    return max_span;
+  }
+
+  DestID_ *neighs_;
+  int64_t *bases_;
+  uint32_t *rel_offsets_;
+  int block_bits_;
+};
+
+
+#if defined(GAPBS_BLOCK_OFFSET_INDEX)
+  template <typename DestID_>
+  using DefaultCSRIndex = BlockOffsetIndex<DestID_>;
+#elif defined(GAPBS_OFFSET_INDEX)
+  template <typename DestID_>
+  using DefaultCSRIndex = OffsetIndex<DestID_>;
+#else
+  template <typename DestID_>
+  using DefaultCSRIndex = PointerIndex<DestID_>;
+#endif
+
+#endif  // CSR_INDEX_H_
@@ -33,7 +33,7 @@ template <typename NodeID_, typename DestID_ = NodeID_,
 class Generator {
   typedef EdgePair<NodeID_, DestID_> Edge;
   typedef EdgePair<NodeID_, NodeWeight<NodeID_, WeightT_>> WEdge;
-  typedef pvector<Edge> EdgeList;
+  typedef pvector<Edge, NewAllocator<Edge>> EdgeList;
 
  public:
   Generator(int scale, int degree) {
@@ -43,8 +43,8 @@ class Generator {
     if (num_nodes_ > std::numeric_limits<NodeID_>::max()) {
       std::cout << "NodeID type (max: " << std::numeric_limits<NodeID_>::max();
       std::cout << ") too small to hold " << num_nodes_ << std::endl;
-      std::cout << "Recommend changing NodeID (typedef'd in src/benchmark.h)";
-      std::cout << " to a wider type and recompiling" << std::endl;
+      std::cout << "Recommend using a binary built with 64-bit IDs (e.g.";
+      std::cout << " bfs64, see Makefile)" << std::endl;
       std::exit(-31);
     }
   }
@@ -126,10 +126,12 @@ class Generator {
     return el;
   }
 
-  static void InsertWeights(pvector<EdgePair<NodeID_, NodeID_>> &el) {}
+  static void InsertWeights(
+      pvector<EdgePair<NodeID_, NodeID_>,
+              NewAllocator<EdgePair<NodeID_, NodeID_>>> &el) {}
 
   // Overwrites existing weights with random from [1,255]
-  static void InsertWeights(pvector<WEdge> &el) {
+  static void InsertWeights(pvector<WEdge, NewAllocator<WEdge>> &el) {
     #pragma omp parallel
     {
       std::mt19937 rng;
@@ -5,12 +5,21 @@
 #define GRAPH_H_
 
 #include <algorithm>
+#include <atomic>
 #include <cinttypes>
 #include <cstddef>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <type_traits>
 
+#include "csr_index.h"
+#include "numa_placement.h"
+#include "platform_atomics.h"
 #include "pvector.h"
+#include "radix_sort.h"
+#include "timer.h"
 #include "util.h"
 
 /*
@@ -22,6 +31,22 @@ Simple container for graph in CSR format
  - Intended to be constructed by a Builder
  - To make weighted, set DestID_ template type to NodeWeight
  - MakeInverse parameter controls whether graph stores its inverse
+ - Neighbor arrays are normally owned (and freed) by the graph, but if given
+   neigh_storage they live inside it instead (e.g. a memory-mapped .sg file)
+ - IndexT (see csr_index.h) finds where neighborhoods start, builders and
+   readers make it (as Index) from their offsets and give it to the graph,
+   which frees it
+ - If directed and MakeInverse, but no inverse is given, it is made by
+   PrepareInverse, by inverse_loader if given (e.g. reading it from a .sg
+   file) or else by transposing the out neighbors in parallel
+ - Unless LazyInverse, whoever makes the graph calls PrepareInverse before
+   handing it out (builders do), so in_neigh and in_degree don't check for it
+ - If LazyInverse, in_neigh and in_degree also make it the first time they
+   are used (checking every call), so runs that never need it don't pay for
+   it, kernels should call PrepareInverse before parallel loops that use the
+   inverse, if it is made inside one it's made by a single thread
+ - After PrepareInverse, prepared_in_neigh and prepared_in_degree read the
+   inverse without checking (even if LazyInverse), for hot loops
 */
 
 // Used to hold node & weight, with another node it makes a weighted edge
@@ -42,19 +67,42 @@ template <typename NodeID_, typename WeightT_> struct NodeWeight {
   // doesn't check WeightT_s, needed to remove self edges
   bool operator==(const NodeID_ &rhs) const { return v == rhs; }
 
-  operator NodeID_() { return v; }
+  operator NodeID_() const { return v; }
 };
 
 template <typename NodeID_, typename WeightT_>
 std::ostream &operator<<(std::ostream &os,
                          const NodeWeight<NodeID_, WeightT_> &nw) {
-  os << nw.v << " " << nw.w;
+  os << nw.v << " " << +nw.w;  // + so 8-bit weights print as numbers
   return os;
 }
 
+// Key for radix sorting neighbors (see radix_sort.h) that orders them like
+// operator< (by ID, then weight)
+template <typename NodeID_>
+inline uint64_t NeighborKey(NodeID_ v) { return OrderedBits(v); }
+
+template <typename NodeID_, typename WeightT_>
+inline auto NeighborKey(const NodeWeight<NodeID_, WeightT_> &nw) {
+  typedef typename std::conditional<
+      (8*(sizeof(NodeID_) + sizeof(WeightT_)) > 64), unsigned __int128,
+      uint64_t>::type KeyT;
+  return (KeyT(OrderedBits(nw.v)) << (8*sizeof(WeightT_))) |
+         OrderedBits(nw.w);
+}
+
+// Serial, since neighborhoods are sorted in parallel with each other
+template <typename DestID_>
+inline void SortNeighborhood(DestID_ *n_start, DestID_ *n_end) {
+  InPlaceRadixSort(n_start, n_end,
+                   [](const DestID_ &v) { return NeighborKey(v); }, false);
+}
+
 template <typename NodeID_, typename WeightT_>
 std::istream &operator>>(std::istream &is, NodeWeight<NodeID_, WeightT_> &nw) {
-  is >> nw.v >> nw.w;
+  decltype(+nw.w) w;
+  is >> nw.v >> w;
+  nw.w = w;
   return is;
 }
 
@@ -81,7 +129,8 @@ typedef int32_t SGID;
 typedef EdgePair<SGID> SGEdge;
 typedef int64_t SGOffset;
 
-template <class NodeID_, class DestID_ = NodeID_, bool MakeInverse = true>
+template <class NodeID_, class DestID_ = NodeID_, bool MakeInverse = true,
+          bool LazyInverse = false, class IndexT = DefaultCSRIndex<DestID_>>
 class CSRGraph {
   // Used for *non-negative* offsets within a neighborhood
   typedef std::make_unsigned<std::ptrdiff_t>::type OffsetT;
@@ -89,11 +138,11 @@ class CSRGraph {
   // Used to access neighbors of vertex, basically sugar for iterators
   class Neighborhood {
     NodeID_ n_;
-    DestID_ **g_index_;
+    IndexT g_index_;
     OffsetT start_offset_;
 
   public:
-    Neighborhood(NodeID_ n, DestID_ **g_index, OffsetT start_offset)
+    Neighborhood(NodeID_ n, const IndexT &g_index, OffsetT start_offset)
         : n_(n), g_index_(g_index), start_offset_(0) {
       OffsetT max_offset = end() - begin();
       start_offset_ = std::min(start_offset, max_offset);
@@ -104,34 +153,113 @@ class CSRGraph {
   };
 
   void ReleaseResources() {
-    if (out_index_ != nullptr)
-      delete[] out_index_;
-    if (out_neighbors_ != nullptr)
+    bool owns_neighs = neigh_storage_ == nullptr;
+    out_index_.Release();
+    if (owns_neighs && out_neighbors_ != nullptr)
       delete[] out_neighbors_;
     if (directed_) {
-      if (in_index_ != nullptr)
-        delete[] in_index_;
-      if (in_neighbors_ != nullptr)
+      in_index_.Release();
+      if ((owns_neighs || owns_inverse_) && in_neighbors_ != nullptr)
         delete[] in_neighbors_;
     }
+    neigh_storage_.reset();
+  }
+
+  // Source u of edge to v as an in-neighbor (keeping weight if weighted)
+  static NodeID_ WithSource(NodeID_ u, NodeID_ v) { return u; }
+
+  template <typename WeightT_>
+  static NodeWeight<NodeID_, WeightT_> WithSource(
+      NodeID_ u, const NodeWeight<NodeID_, WeightT_> &v) {
+    return NodeWeight<NodeID_, WeightT_>(u, v.w);
+  }
+
+  // Makes inverse from out neighbors in parallel: count in-degrees, place
+  // every edge at its destination's next free slot, then (if sort_inverse_)
+  // sort each in-neighborhood, since placement order depends on threads
+  void TransposeOut(IndexT *index, DestID_ **neighs) const {
+    pvector<SGOffset> offsets;
+    {
+      pvector<SGOffset> degrees(num_nodes_, 0);
+#pragma omp parallel for schedule(dynamic, 1024)
+      for (NodeID_ u = 0; u < num_nodes_; u++) {
+        for (DestID_ v : out_neigh(u))
+          fetch_and_add(degrees[static_cast<NodeID_>(v)], 1);
+      }
+      offsets = ParallelPrefixSum(degrees);
+    }
+    const SGOffset total = offsets[num_nodes_];
+    *neighs = new DestID_[total];
+    NUMAPlaceNeighs(*neighs, offsets.data(), num_nodes_);
+    AdviseArray(*neighs, total);
+    *index = IndexT(offsets.data(), num_nodes_, *neighs);
+    // offsets now used as each in-neighborhood's next free slot
+#pragma omp parallel for schedule(dynamic, 1024)
+    for (NodeID_ u = 0; u < num_nodes_; u++) {
+      for (DestID_ v : out_neigh(u))
+        (*neighs)[fetch_and_add(offsets[static_cast<NodeID_>(v)], 1)] =
+            WithSource(u, v);
+    }
+    if (!sort_inverse_)
+      return;
+#pragma omp parallel for schedule(dynamic, 1024)
+    for (NodeID_ n = 0; n < num_nodes_; n++)
+      SortNeighborhood((*index)[n], (*index)[n + 1]);
+  }
+
+  // Only the first caller makes the inverse, others wait for it
+  void EnsureInverse() const {
+    if (inverse_ready_.load(std::memory_order_acquire))
+      return;
+    std::lock_guard<std::mutex> guard(inverse_mutex_);
+    if (inverse_ready_.load(std::memory_order_relaxed))
+      return;
+    Timer t;
+    t.Start();
+    if (inverse_loader_) {
+      in_index_ = inverse_loader_(&in_neighbors_);
+    } else {
+      TransposeOut(&in_index_, &in_neighbors_);
+      owns_inverse_ = true;
+    }
+    inverse_loader_ = nullptr;
+    t.Stop();
+    PrintTime("Inverse Time", t.Seconds());
+    inverse_ready_.store(true, std::memory_order_release);
   }
 
 public:
-  CSRGraph()
-      : directed_(false), num_nodes_(-1), num_edges_(-1), out_index_(nullptr),
-        out_neighbors_(nullptr), in_index_(nullptr), in_neighbors_(nullptr) {}
+  typedef IndexT Index;
 
-  CSRGraph(int64_t num_nodes, DestID_ **index, DestID_ *neighs)
-      : directed_(false), num_nodes_(num_nodes), out_index_(index),
-        out_neighbors_(neighs), in_index_(index), in_neighbors_(neighs) {
+  // Makes inverse neighbors (setting neighs to them) and returns their index,
+  // they are owned like the out neighbors are
+  typedef std::function<IndexT(DestID_ **neighs)> InverseLoader;
+
+  CSRGraph()
+      : directed_(false), num_nodes_(-1), num_edges_(-1),
+        out_neighbors_(nullptr), in_neighbors_(nullptr), inverse_ready_(true),
+        owns_inverse_(false) {}
+
+  CSRGraph(int64_t num_nodes, IndexT index, DestID_ *neighs,
+           std::shared_ptr<void> neigh_storage = nullptr)
+      : directed_(false), num_nodes_(num_nodes),
+        out_index_(index), out_neighbors_(neighs),
+        in_index_(out_index_), in_neighbors_(neighs),
+        neigh_storage_(neigh_storage), inverse_ready_(true),
+        owns_inverse_(false) {
     num_edges_ = (out_index_[num_nodes_] - out_index_[0]) / 2;
   }
 
-  CSRGraph(int64_t num_nodes, DestID_ **out_index, DestID_ *out_neighs,
-           DestID_ **in_index, DestID_ *in_neighs)
+  // If in_index is empty, inverse is made when first needed (see above)
+  CSRGraph(int64_t num_nodes, IndexT out_index, DestID_ *out_neighs,
+           IndexT in_index, DestID_ *in_neighs,
+           std::shared_ptr<void> neigh_storage = nullptr,
+           InverseLoader inverse_loader = nullptr)
       : directed_(true), num_nodes_(num_nodes), out_index_(out_index),
         out_neighbors_(out_neighs), in_index_(in_index),
-        in_neighbors_(in_neighs) {
+        in_neighbors_(in_neighs), neigh_storage_(neigh_storage),
+        inverse_ready_(!MakeInverse || !in_index.empty()),
+        owns_inverse_(false), inverse_loader_(inverse_loader) {
     num_edges_ = out_index_[num_nodes_] - out_index_[0];
   }
 
@@ -139,13 +267,21 @@ public:
       : directed_(other.directed_), num_nodes_(other.num_nodes_),
         num_edges_(other.num_edges_), out_index_(other.out_index_),
         out_neighbors_(other.out_neighbors_), in_index_(other.in_index_),
-        in_neighbors_(other.in_neighbors_) {
+        in_neighbors_(other.in_neighbors_),
+        neigh_storage_(std::move(other.neigh_storage_)),
+        inverse_ready_(other.inverse_ready_.load()),
+        owns_inverse_(other.owns_inverse_),
+        sort_inverse_(other.sort_inverse_),
+        inverse_loader_(std::move(other.inverse_loader_)) {
     other.num_edges_ = -1;
     other.num_nodes_ = -1;
-    other.out_index_ = nullptr;
+    other.out_index_ = IndexT();
     other.out_neighbors_ = nullptr;
-    other.in_index_ = nullptr;
+    other.in_index_ = IndexT();
     other.in_neighbors_ = nullptr;
+    other.inverse_ready_ = true;
+    other.owns_inverse_ = false;
+    other.inverse_loader_ = nullptr;
   }
 
   ~CSRGraph() { ReleaseResources(); }
@@ -160,12 +296,20 @@ public:
       out_neighbors_ = other.out_neighbors_;
       in_index_ = other.in_index_;
       in_neighbors_ = other.in_neighbors_;
+      neigh_storage_ = std::move(other.neigh_storage_);
+      inverse_ready_ = other.inverse_ready_.load();
+      owns_inverse_ = other.owns_inverse_;
+      sort_inverse_ = other.sort_inverse_;
+      inverse_loader_ = std::move(other.inverse_loader_);
       other.num_edges_ = -1;
       other.num_nodes_ = -1;
-      other.out_index_ = nullptr;
+      other.out_index_ = IndexT();
       other.out_neighbors_ = nullptr;
-      other.in_index_ = nullptr;
+      other.in_index_ = IndexT();
       other.in_neighbors_ = nullptr;
+      other.inverse_ready_ = true;
+      other.owns_inverse_ = false;
+      other.inverse_loader_ = nullptr;
     }
     return *this;
   }
@@ -186,6 +330,8 @@ public:
 
   int64_t in_degree(NodeID_ v) const {
     static_assert(MakeInverse, "Graph inversion disabled but reading inverse");
+    if constexpr (LazyInverse)
+      EnsureInverse();
     return in_index_[v + 1] - in_index_[v];
   }
 
@@ -195,9 +341,60 @@ public:
 
   Neighborhood in_neigh(NodeID_ n, OffsetT start_offset = 0) const {
     static_assert(MakeInverse, "Graph inversion disabled but reading inverse");
+    if constexpr (LazyInverse)
+      EnsureInverse();
     return Neighborhood(n, in_index_, start_offset);
   }
 
+  // Same as in_degree and in_neigh, but only after PrepareInverse
+  int64_t prepared_in_degree(NodeID_ v) const {
+    static_assert(MakeInverse, "Graph inversion disabled but reading inverse");
+    return in_index_[v + 1] - in_index_[v];
+  }
+
+  Neighborhood prepared_in_neigh(NodeID_ n, OffsetT start_offset = 0) const {
+    static_assert(MakeInverse, "Graph inversion disabled but reading inverse");
+    return Neighborhood(n, in_index_, start_offset);
+  }
+
+  // Makes inverse now (in parallel) if it hasn't been yet
+  void PrepareInverse() const {
+    static_assert(MakeInverse, "Graph inversion disabled but reading inverse");
+    EnsureInverse();
+  }
+
+  // False only if inverse hasn't been made yet
+  bool inverse_ready() const {
+    return inverse_ready_.load(std::memory_order_acquire);
+  }
+
+  // Hands neighbors of one direction (both if undirected) to caller, who
+  // frees them with delete[], or returns null if graph doesn't own them
+  // (e.g. memory-mapped), so they can be converted in place. Afterwards
+  // graph can only be destroyed or assigned to.
+  DestID_* ReleaseNeighbors(bool in_graph) {
+    DestID_ *neighs;
+    if (!in_graph || !directed_) {
+      if (neigh_storage_ != nullptr)
+        return nullptr;
+      neighs = out_neighbors_;
+      out_neighbors_ = nullptr;
+      if (!directed_)
+        in_neighbors_ = nullptr;
+    } else {
+      EnsureInverse();
+      if ((neigh_storage_ != nullptr) && !owns_inverse_)
+        return nullptr;
+      neighs = in_neighbors_;
+      in_neighbors_ = nullptr;
+    }
+    return neighs;
+  }
+
+  // Inverse made by transposing is sorted unless cleared (by builders of
+  // graphs that don't need sorted neighborhoods)
+  void set_sort_inverse(bool sort_inverse) { sort_inverse_ = sort_inverse; }
+
   void PrintStats() const {
     std::cout << "Graph has " << num_nodes_ << " nodes and " << num_edges_
               << " ";
@@ -217,20 +414,9 @@ public:
     }
   }
 
-  static DestID_ **GenIndex(const pvector<SGOffset> &offsets, DestID_ *neighs) {
-    NodeID_ length = offsets.size();
-    DestID_ **index = new DestID_ *[length];
-    std::cout << "index: " << *index << " ; "
-              << static_cast<intptr_t>(reinterpret_cast<intptr_t>(*index))
-              << "\n"
-              << std::flush;
-#pragma omp parallel for
-    for (NodeID_ n = 0; n < length; n++)
-      index[n] = neighs + offsets[n];
-    return index;
-  }
-
   pvector<SGOffset> VertexOffsets(bool in_graph = false) const {
+    if (in_graph)
+      EnsureInverse();
     pvector<SGOffset> offsets(num_nodes_ + 1);
     for (NodeID_ n = 0; n < num_nodes_ + 1; n++)
       if (in_graph)
@@ -246,10 +432,16 @@ private:
   bool directed_;
   int64_t num_nodes_;
   int64_t num_edges_;
-  DestID_ **out_index_;
+  IndexT out_index_;
   DestID_ *out_neighbors_;
-  DestID_ **in_index_;
-  DestID_ *in_neighbors_;
+  mutable IndexT in_index_;
+  mutable DestID_ *in_neighbors_;
+  std::shared_ptr<void> neigh_storage_;
+  mutable std::atomic<bool> inverse_ready_;
+  mutable std::mutex inverse_mutex_;
+  mutable bool owns_inverse_;  // made by transposing, so always freed
+  bool sort_inverse_ = true;   // whether transposing sorts neighborhoods
+  mutable InverseLoader inverse_loader_;
 };
 
 #endif // GRAPH_H_
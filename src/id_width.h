@@ -0,0 +1,91 @@
+// Copyright (c) 2015, The Regents of the University of California (Regents)
+// See LICENSE.txt for license details
+
+#ifndef ID_WIDTH_H_
+#define ID_WIDTH_H_
+
+#include <unistd.h>
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "command_line.h"
+#include "sg_format.h"
+#include "util.h"
+
+
+/*
+GAP Benchmark Suite
+File:   ID Width
+
+Picks vertex ID width (32 or 64-bit) from the input at runtime, so the same
+command works on any graph while graphs that fit keep 32-bit IDs
+ - Every binary is also built with 64-bit NodeIDs (e.g. bfs64, built with
+   -DGAPBS_64BIT_IDS, see Makefile), and the two run each other as needed
+ - Serialized graphs (.sg & .wsg) record their ID width in their header and
+   are loaded as stored, so they need the binary of that width
+ - Generated graphs need 64-bit IDs from scale 31 on
+ - Edge lists only find out while being read (Reader notes IDs too big), so
+   the 32-bit binary runs the 64-bit one after reading one with such IDs
+ - The other binary replaces this process (exec) and is given the same
+   arguments, so it is found next to this one (by appending or removing 64)
+*/
+
+
+// ID width (bytes) input must be loaded with, 0 if any width can be used
+inline size_t InputIDBytes(const CLBase &cli) {
+  if (cli.filename() == "")
+    return cli.scale() >= 31 ? sizeof(int64_t) : 0;
+  const std::string &filename = cli.filename();
+  const size_t suff_pos = filename.rfind('.');
+  const std::string suffix = suff_pos == std::string::npos ? "" :
+                             filename.substr(suff_pos);
+  if ((suffix != ".sg") && (suffix != ".wsg"))
+    return 0;
+  std::ifstream file(filename, std::ios::binary);
+  SGHeader header;
+  file.read(reinterpret_cast<char*>(&header), sizeof(SGHeader));
+  if (!file)  // version 1 files are shorter than SGHeader
+    return (file.gcount() > 0) ? sizeof(SGID) : 0;
+  if (!SGHasMagic(header.magic, sizeof(header.magic)))
+    return sizeof(SGID);
+  return header.id_bytes;
+}
+
+// Path of the binary built with id_bytes-wide IDs next to this one
+inline std::string SiblingBinary(size_t id_bytes) {
+  char path[4096];
+  ssize_t length = readlink("/proc/self/exe", path, sizeof(path) - 1);
+  if (length <= 0)
+    return "";
+  std::string self(path, length);
+  if (id_bytes == sizeof(int64_t))
+    return self + "64";
+  if ((self.size() > 2) && (self.compare(self.size() - 2, 2, "64") == 0))
+    return self.substr(0, self.size() - 2);
+  return "";
+}
+
+// Returns if NodeID_ is id_bytes wide (or id_bytes is 0), otherwise replaces
+// this process with the binary of that width, run with the same arguments
+template <typename NodeID_>
+void RunWithIDBytes(size_t id_bytes, const CLBase &cli) {
+  if ((id_bytes == 0) || (id_bytes == sizeof(NodeID_)))
+    return;
+  PrintLabel("Vertex IDs", std::to_string(8 * id_bytes) + "-bit");
+  std::string sibling = SiblingBinary(id_bytes);
+  std::cout << std::flush;
+  std::fflush(stdout);
+  if (sibling != "")
+    execv(sibling.c_str(), cli.argv());
+  std::cout << "Couldn't run " << (sibling == "" ? "binary" : sibling)
+            << " for " << 8 * id_bytes << "-bit IDs (build it with make)"
+            << std::endl;
+  std::exit(-19);
+}
+
+#endif  // ID_WIDTH_H_
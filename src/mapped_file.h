@@ -0,0 +1,94 @@
+// Copyright (c) 2015, The Regents of the University of California (Regents)
+// See LICENSE.txt for license details
+
+#ifndef MAPPED_FILE_H_
+#define MAPPED_FILE_H_
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+
+/*
+GAP Benchmark Suite
+Class:  MappedFile
+
+Read-only memory mapping of an entire file
+ - Pages come directly from the OS page cache, so nothing is copied into
+   process memory and repeated runs on a cached file share the same pages
+ - Pointers into the mapping are only valid while the MappedFile lives, so
+   objects pointing into it (e.g. CSRGraph) hold it with a shared_ptr
+*/
+
+
+class MappedFile {
+ public:
+  explicit MappedFile(std::string filename) : data_(nullptr), size_(0) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd == -1) {
+      std::cout << "Couldn't open file " << filename << std::endl;
+      std::exit(-6);
+    }
+    struct stat file_stats;
+    if (fstat(fd, &file_stats) != 0) {
+      std::cout << "Couldn't stat file " << filename << std::endl;
+      std::exit(-6);
+    }
+    size_ = file_stats.st_size;
+    if (size_ != 0) {
+      void *mapping = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+      if (mapping == MAP_FAILED) {
+        std::cout << "Couldn't mmap file " << filename << std::endl;
+        std::exit(-7);
+      }
+      data_ = static_cast<char*>(mapping);
+    }
+    close(fd);
+  }
+
+  // don't want this to be copied, would unmap twice
+  MappedFile(const MappedFile &other) = delete;
+  MappedFile& operator=(const MappedFile &other) = delete;
+
+  ~MappedFile() {
+    if (data_ != nullptr)
+      munmap(data_, size_);
+  }
+
+  // Hint to the OS how the mapping will be accessed (e.g. MADV_SEQUENTIAL)
+  void Advise(int advice) const {
+    if (data_ != nullptr)
+      madvise(data_, size_, advice);
+  }
+
+  const char* data() const { return data_; }
+
+  size_t size() const { return size_; }
+
+ private:
+  char *data_;
+  size_t size_;
+};
+
+
+// Copies large buffers with all threads (e.g. out of a MappedFile)
+inline void ParallelCopy(void *dst, const void *src, size_t num_bytes) {
+  const size_t block_size = 1 << 22;
+  const int64_t num_blocks = (num_bytes + block_size - 1) / block_size;
+  #pragma omp parallel for schedule(static)
+  for (int64_t block = 0; block < num_blocks; block++) {
+    size_t start = block * block_size;
+    size_t length = std::min(block_size, num_bytes - start);
+    std::memcpy(static_cast<char*>(dst) + start,
+                static_cast<const char*>(src) + start, length);
+  }
+}
+
+#endif  // MAPPED_FILE_H_
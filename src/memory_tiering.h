@@ -0,0 +1,435 @@
+// Copyright (c) 2015, The Regents of the University of California (Regents)
+// See LICENSE.txt for license details
+
+#ifndef MEMORY_TIERING_H_
+#define MEMORY_TIERING_H_
+
+#include <fcntl.h>
+#include <numa.h>
+#include <numaif.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cinttypes>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "numa_placement.h"
+
+
+/*
+GAP Benchmark Suite
+File:   Memory Tiering
+
+Places graph data on a fast and a slow memory tier (NUMA nodes, e.g. a slow
+far-memory tier shows up as a node without CPUs) by how often it's expected
+to be accessed
+ - Tiers are set once for the process (-T fast:slow[:fraction][:migrate] on
+   command line, see CLBase)
+ - Neighbors of high-degree vertices are hot (read by many traversals), up
+   to fraction (default 0.25) of the neighbor bytes, the rest is cold and is
+   moved to the slow node
+ - Everything allocated afterwards (per-vertex arrays like parent or scores,
+   frontier queues) prefers the fast node, since kernels write it constantly
+ - With one node (or fast == slow) pages are classified and reported but not
+   moved, so the tiering can still be tested
+ - migrate starts a background thread that samples cold pages with the
+   kernel's idle page tracking (needs root and CONFIG_IDLE_PAGE_TRACKING) and
+   promotes the ones that were accessed to the fast node
+*/
+
+
+struct TierSettings {
+  bool enabled = false;
+  int fast_node = 0;
+  int slow_node = 0;
+  double hot_fraction = 0.25;
+  bool migrate = false;
+};
+
+inline TierSettings& TierGlobalSettings() {
+  static TierSettings settings;
+  return settings;
+}
+
+// Returns false if spec isn't fast:slow[:fraction][:migrate] with existing
+// nodes and fraction within [0, 1]
+inline bool ParseTierSpec(const std::string &spec, TierSettings *settings) {
+  std::vector<std::string> fields;
+  size_t start = 0;
+  while (true) {
+    size_t colon = spec.find(':', start);
+    fields.push_back(spec.substr(start, colon - start));
+    if (colon == std::string::npos)
+      break;
+    start = colon + 1;
+  }
+  if ((fields.size() < 2) || (fields.size() > 4))
+    return false;
+  for (int i = 0; i < 2; i++) {
+    if (fields[i].empty() ||
+        (fields[i].find_first_not_of("0123456789") != std::string::npos))
+      return false;
+  }
+  settings->fast_node = std::atoi(fields[0].c_str());
+  settings->slow_node = std::atoi(fields[1].c_str());
+  settings->migrate = false;
+  for (size_t i = 2; i < fields.size(); i++) {
+    if (fields[i] == "migrate") {
+      settings->migrate = true;
+    } else if (i == 2) {
+      char *end;
+      settings->hot_fraction = std::strtod(fields[i].c_str(), &end);
+      if (fields[i].empty() || (*end != '\0') ||
+          !(settings->hot_fraction >= 0) || (settings->hot_fraction > 1))
+        return false;
+    } else {
+      return false;
+    }
+  }
+  settings->enabled = true;
+  return (settings->fast_node < NUMANumNodes()) &&
+         (settings->slow_node < NUMANumNodes());
+}
+
+// Only moves pages if there are two different tiers
+inline bool TiersSeparate() {
+  const TierSettings &settings = TierGlobalSettings();
+  return settings.enabled && (settings.fast_node != settings.slow_node) &&
+         (numa_available() >= 0);
+}
+
+// Moves whole pages already in [begin, end) to node (and keeps new ones
+// there), like test_mbind() in test.cc but on graph ranges with a libnuma
+// nodemask, and preferred rather than bound, so a full fast tier spills over,
+// returns errno of mbind if it failed (else 0)
+inline int TierMoveRange(char *begin, char *end, int node) {
+  if (end <= begin)
+    return 0;
+  struct bitmask *mask = numa_allocate_nodemask();
+  numa_bitmask_setbit(mask, node);
+  int error = 0;
+  if (mbind(begin, end - begin, MPOL_PREFERRED, mask->maskp, mask->size + 1,
+            MPOL_MF_MOVE) != 0)
+    error = errno;
+  numa_free_nodemask(mask);
+  return error;
+}
+
+// Allocations from now on (that aren't placed by -N) prefer the fast node,
+// policy is per thread, so it's set on every OpenMP thread too
+inline void TierPreferFast() {
+  if (!TiersSeparate())
+    return;
+  numa_set_preferred(TierGlobalSettings().fast_node);
+  #pragma omp parallel
+  numa_set_preferred(TierGlobalSettings().fast_node);
+}
+
+
+/*
+GAP Benchmark Suite
+Class:  TierMigrator
+
+Promotes cold pages the kernels turn out to access (online migration)
+ - Every interval, marks a random sample of the cold pages idle (physical
+   frames from /proc/self/pagemap, idle bits in page_idle/bitmap), and after
+   the interval moves the ones no longer idle to the fast node
+ - Only one for the process (Start), stopped and joined at exit, which also
+   prints how much was promoted
+*/
+
+class TierMigrator {
+ public:
+  typedef std::pair<char*, char*> PageRun;
+
+  static void Start(const std::vector<PageRun> &cold_runs, int fast_node) {
+    static TierMigrator migrator;
+    migrator.Launch(cold_runs, fast_node);
+  }
+
+  ~TierMigrator() {
+    if (!thread_.joinable())
+      return;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+    thread_.join();
+    printf("%-14s%14" PRId64 "\n", "Promoted MB:",
+           promoted_pages_ * page_bytes_ >> 20);
+    close(pagemap_fd_);
+    close(idle_fd_);
+  }
+
+ private:
+  static const int kSamplePages = 4096;
+  static constexpr std::chrono::milliseconds kInterval{200};
+
+  TierMigrator() : page_bytes_(sysconf(_SC_PAGESIZE)) {}
+
+  void Launch(const std::vector<PageRun> &cold_runs, int fast_node) {
+    if (thread_.joinable() || cold_runs.empty())
+      return;
+    pagemap_fd_ = open("/proc/self/pagemap", O_RDONLY);
+    idle_fd_ = open("/sys/kernel/mm/page_idle/bitmap", O_RDWR);
+    if ((pagemap_fd_ < 0) || (idle_fd_ < 0) ||
+        (FrameOf(cold_runs[0].first) == 0)) {
+      std::cout << "Access sampling unavailable, not migrating" << std::endl;
+      if (pagemap_fd_ >= 0)
+        close(pagemap_fd_);
+      if (idle_fd_ >= 0)
+        close(idle_fd_);
+      return;
+    }
+    runs_ = cold_runs;
+    run_ends_.clear();
+    int64_t num_pages = 0;
+    for (const PageRun &run : runs_) {
+      num_pages += (run.second - run.first) / page_bytes_;
+      run_ends_.push_back(num_pages);
+    }
+    fast_node_ = fast_node;
+    thread_ = std::thread(&TierMigrator::Run, this);
+  }
+
+  // Physical frame of page at addr (0 if not present or not visible)
+  uint64_t FrameOf(char *addr) const {
+    uint64_t entry = 0;
+    off_t offset = reinterpret_cast<uintptr_t>(addr) / page_bytes_ * 8;
+    if (pread(pagemap_fd_, &entry, 8, offset) != 8)
+      return 0;
+    if (!(entry >> 63))
+      return 0;
+    return entry & ((uint64_t(1) << 55) - 1);
+  }
+
+  void SetIdle(uint64_t frame) const {
+    uint64_t word = uint64_t(1) << (frame % 64);
+    if (pwrite(idle_fd_, &word, 8, frame / 64 * 8) != 8)
+      return;
+  }
+
+  bool IsIdle(uint64_t frame) const {
+    uint64_t word = 0;
+    if (pread(idle_fd_, &word, 8, frame / 64 * 8) != 8)
+      return true;
+    return (word >> (frame % 64)) & 1;
+  }
+
+  char* PageAt(int64_t page) const {
+    size_t run = std::upper_bound(run_ends_.begin(), run_ends_.end(), page) -
+                 run_ends_.begin();
+    int64_t run_start = run == 0 ? 0 : run_ends_[run - 1];
+    return runs_[run].first + (page - run_start) * page_bytes_;
+  }
+
+  void Run() {
+    std::mt19937_64 rng(27491095);
+    std::uniform_int_distribution<int64_t> page_dist(0, run_ends_.back() - 1);
+    std::vector<std::pair<char*, uint64_t>> sample;
+    std::vector<void*> accessed;
+    std::vector<int> nodes, status;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_) {
+      sample.clear();
+      for (int i = 0; i < kSamplePages; i++) {
+        char *page = PageAt(page_dist(rng));
+        uint64_t frame = FrameOf(page);
+        if (frame != 0) {
+          SetIdle(frame);
+          sample.emplace_back(page, frame);
+        }
+      }
+      if (wake_.wait_for(lock, kInterval, [this] { return stop_; }))
+        break;
+      accessed.clear();
+      for (auto page_frame : sample) {
+        if (!IsIdle(page_frame.second))
+          accessed.push_back(page_frame.first);
+      }
+      if (accessed.empty())
+        continue;
+      nodes.assign(accessed.size(), fast_node_);
+      status.assign(accessed.size(), 0);
+      numa_move_pages(0, accessed.size(), accessed.data(), nodes.data(),
+                      status.data(), MPOL_MF_MOVE);
+      for (int s : status)
+        promoted_pages_ += s == fast_node_;
+    }
+  }
+
+  const int64_t page_bytes_;
+  int pagemap_fd_ = -1;
+  int idle_fd_ = -1;
+  int fast_node_ = 0;
+  std::vector<PageRun> runs_;
+  std::vector<int64_t> run_ends_;
+  int64_t promoted_pages_ = 0;
+  bool stop_ = false;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::thread thread_;
+};
+
+
+/*
+GAP Benchmark Suite
+Class:  TierPlan
+
+Splits a neighbors array (of any graph with contiguous neighborhoods) into
+hot and cold pages and moves them to their tiers
+ - Threshold is the lowest power of two such that neighbors of vertices with
+   at least that degree fit within the hot fraction of all neighbor bytes
+ - A page is hot if any vertex with its neighbors on it is hot, so
+   neighborhoods of hot vertices are never split across tiers
+ - Only whole pages are classified (and counted), partial pages at the ends
+   of the array stay where they are
+*/
+
+class TierPlan {
+ public:
+  typedef TierMigrator::PageRun PageRun;
+
+  template <typename NeighFunc>
+  void Classify(int64_t num_nodes, NeighFunc neigh) {
+    if (num_nodes == 0)
+      return;
+    const int64_t degree_threshold = DegreeThreshold(num_nodes, neigh);
+    const uintptr_t page_bytes = sysconf(_SC_PAGESIZE);
+    uintptr_t first = reinterpret_cast<uintptr_t>(neigh(0).begin());
+    first = (first + page_bytes - 1) / page_bytes * page_bytes;
+    uintptr_t last = reinterpret_cast<uintptr_t>(neigh(num_nodes - 1).end());
+    last = last / page_bytes * page_bytes;
+    if (last <= first)
+      return;
+    const int64_t num_pages = (last - first) / page_bytes;
+    std::vector<uint8_t> hot(num_pages);
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for (int64_t p = 0; p < num_pages; p++) {
+      char *page_start = reinterpret_cast<char*>(first + p * page_bytes);
+      char *page_end = page_start + page_bytes;
+      // first vertex with neighbors ending after start of page
+      int64_t lo = 0, hi = num_nodes - 1;
+      while (lo < hi) {
+        int64_t mid = lo + (hi - lo) / 2;
+        if (ToChar(neigh(mid).end()) <= page_start)
+          lo = mid + 1;
+        else
+          hi = mid;
+      }
+      hot[p] = 0;
+      for (int64_t v = lo; v < num_nodes; v++) {
+        auto n = neigh(v);
+        if (ToChar(n.begin()) >= page_end)
+          break;
+        if (n.end() - n.begin() >= degree_threshold) {
+          hot[p] = 1;
+          break;
+        }
+      }
+    }
+    for (int64_t p = 0; p < num_pages; ) {
+      int64_t run_end = p;
+      while ((run_end < num_pages) && (hot[run_end] == hot[p]))
+        run_end++;
+      PageRun run(reinterpret_cast<char*>(first + p * page_bytes),
+                  reinterpret_cast<char*>(first + run_end * page_bytes));
+      (hot[p] ? hot_runs_ : cold_runs_).push_back(run);
+      (hot[p] ? hot_bytes_ : cold_bytes_) += (run_end - p) * page_bytes;
+      p = run_end;
+    }
+  }
+
+  // Does nothing (besides classifying) unless tiers are separate, warns
+  // (once) if any runs couldn't be moved, those aren't counted as moved
+  void Apply() {
+    if (!TiersSeparate())
+      return;
+    const TierSettings &settings = TierGlobalSettings();
+    int64_t failed_runs = 0;
+    int first_error = 0;
+    auto move_runs = [&](const std::vector<PageRun> &runs, int node) {
+      for (const PageRun &run : runs) {
+        int error = TierMoveRange(run.first, run.second, node);
+        if (error == 0) {
+          moved_bytes_ += run.second - run.first;
+        } else if (failed_runs++ == 0) {
+          first_error = error;
+        }
+      }
+    };
+    move_runs(hot_runs_, settings.fast_node);
+    move_runs(cold_runs_, settings.slow_node);
+    if (failed_runs != 0)
+      std::cout << "Couldn't move " << failed_runs << " page runs to their "
+                << "tiers: " << std::strerror(first_error) << std::endl;
+  }
+
+  void StartMigration() const {
+    if (!TiersSeparate()) {
+      std::cout << "Single memory tier, not migrating" << std::endl;
+      return;
+    }
+    TierMigrator::Start(cold_runs_, TierGlobalSettings().fast_node);
+  }
+
+  // Planned bytes of each tier, and bytes actually moved to their tier
+  int64_t hot_bytes() const { return hot_bytes_; }
+  int64_t cold_bytes() const { return cold_bytes_; }
+  int64_t moved_bytes() const { return moved_bytes_; }
+
+ private:
+  template <typename T_>
+  static char* ToChar(T_ *ptr) {
+    typedef typename std::remove_const<T_>::type MutableT;
+    return reinterpret_cast<char*>(const_cast<MutableT*>(ptr));
+  }
+
+  template <typename NeighFunc>
+  static int64_t DegreeThreshold(int64_t num_nodes, NeighFunc neigh) {
+    const int kNumBuckets = 64;
+    int64_t bucket_edges[kNumBuckets] = {};
+    #pragma omp parallel for reduction(+ : bucket_edges[:kNumBuckets])
+    for (int64_t v = 0; v < num_nodes; v++) {
+      auto n = neigh(v);
+      int64_t degree = n.end() - n.begin();
+      if (degree > 0)
+        bucket_edges[63 - __builtin_clzll(degree)] += degree;
+    }
+    int64_t total_edges = 0;
+    for (int b = 0; b < kNumBuckets; b++)
+      total_edges += bucket_edges[b];
+    const double budget = TierGlobalSettings().hot_fraction * total_edges;
+    int64_t hot_edges = 0;
+    int64_t threshold = std::numeric_limits<int64_t>::max();
+    for (int b = kNumBuckets - 1; b >= 0; b--) {
+      if (hot_edges + bucket_edges[b] > budget)
+        break;
+      hot_edges += bucket_edges[b];
+      threshold = int64_t(1) << b;
+    }
+    return threshold;
+  }
+
+  std::vector<PageRun> hot_runs_, cold_runs_;
+  int64_t hot_bytes_ = 0;
+  int64_t cold_bytes_ = 0;
+  int64_t moved_bytes_ = 0;
+};
+
+#endif  // MEMORY_TIERING_H_
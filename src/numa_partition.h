@@ -0,0 +1,146 @@
+// Copyright (c) 2015, The Regents of the University of California (Regents)
+// See LICENSE.txt for license details
+
+#ifndef NUMA_PARTITION_H_
+#define NUMA_PARTITION_H_
+
+#include <numa.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <vector>
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+#include "numa_placement.h"
+#include "platform_atomics.h"
+
+
+/*
+GAP Benchmark Suite
+Class:  NUMAPartitions
+
+Splits vertices into one contiguous range (shard) per NUMA node, so kernels
+can process each shard with threads running on that node
+ - Shards are the same vertex ranges -N partitioned places CSR neighbors,
+   indices, and pvectors by (NUMAPartStart over NUMACPUNodes), so a shard's
+   neighbor reads and per-vertex writes are node-local without copying the
+   graph, nodes without CPUs (e.g. CXL memory) get no shard
+ - Only partitioned (more than one shard) if -N partitioned on a machine with
+   multiple CPU nodes, otherwise one shard and loops behave like
+   schedule(dynamic, chunk)
+ - Threads are assigned to shards in order (thread t of T to shard t*K/T)
+   and pinned to their shard's node (numa_run_on_node) only for the loop,
+   their previous affinity is restored when it ends so later loops (and the
+   builder or verifier) are unaffected, if pinning fails the thread still
+   starts on its shard but isn't node-local
+ - Each thread claims chunks from its own shard first, then helps the other
+   shards once its own is done (so all vertices are done with any number of
+   threads)
+*/
+
+
+class NUMAPartitions {
+ public:
+  explicit NUMAPartitions(int64_t num_vertices)
+      : num_vertices_(num_vertices), num_parts_(1) {
+    if (NUMAGlobalSettings().policy == NUMAPolicy::kPartitioned)
+      num_parts_ = std::max<int64_t>(1, std::min<int64_t>(
+                       NUMACPUNodes().size(), num_vertices));
+  }
+
+  int num_parts() const { return num_parts_; }
+
+  int64_t part_start(int part) const {
+    return NUMAPartStart(num_vertices_, part, num_parts_);
+  }
+
+  // Calls body(v) for every vertex, returns sum of what it returns
+  template <typename T_, typename BodyFunc>
+  T_ SumLocal(BodyFunc body, int64_t chunk_size = 1024) const {
+    T_ total = 0;
+    if (num_parts_ == 1) {
+      #pragma omp parallel for reduction(+ : total) \
+                               schedule(dynamic, chunk_size)
+      for (int64_t v = 0; v < num_vertices_; v++)
+        total += body(v);
+      return total;
+    }
+    std::vector<PaddedCursor> cursors(num_parts_);
+    for (int p = 0; p < num_parts_; p++)
+      cursors[p].next = part_start(p);
+    #pragma omp parallel reduction(+ : total)
+    {
+      const int home = HomePart();
+      NodePin pin(NUMACPUNodes()[home]);
+      for (int i = 0; i < num_parts_; i++) {
+        const int p = (home + i) % num_parts_;
+        const int64_t end = part_start(p + 1);
+        while (true) {
+          int64_t start = fetch_and_add(cursors[p].next, chunk_size);
+          if (start >= end)
+            break;
+          for (int64_t v = start; v < std::min(end, start + chunk_size); v++)
+            total += body(v);
+        }
+      }
+    }
+    return total;
+  }
+
+  // Calls body(v) for every vertex
+  template <typename BodyFunc>
+  void ForEachLocal(BodyFunc body, int64_t chunk_size = 1024) const {
+    SumLocal<int64_t>([&body](int64_t v) { body(v); return 0; }, chunk_size);
+  }
+
+ private:
+  struct alignas(64) PaddedCursor {
+    int64_t next;
+  };
+
+  // Runs calling thread on node while in scope, then restores its affinity
+  class NodePin {
+   public:
+    explicit NodePin(int node) : saved_(numa_allocate_cpumask()) {
+      if (numa_sched_getaffinity(0, saved_) < 0) {
+        numa_free_cpumask(saved_);
+        saved_ = nullptr;
+      } else if (numa_run_on_node(node) != 0) {
+        numa_sched_setaffinity(0, saved_);
+        numa_free_cpumask(saved_);
+        saved_ = nullptr;
+      }
+    }
+
+    ~NodePin() {
+      if (saved_ != nullptr) {
+        numa_sched_setaffinity(0, saved_);
+        numa_free_cpumask(saved_);
+      }
+    }
+
+    NodePin(const NodePin&) = delete;
+    NodePin& operator=(const NodePin&) = delete;
+
+   private:
+    struct bitmask *saved_;
+  };
+
+  // Shard calling thread works on first
+  int HomePart() const {
+    int thread = 0, num_threads = 1;
+    #ifdef _OPENMP
+      thread = omp_get_thread_num();
+      num_threads = omp_get_num_threads();
+    #endif
+    return static_cast<int64_t>(thread) * num_parts_ / num_threads;
+  }
+
+  int64_t num_vertices_;
+  int num_parts_;
+};
+
+#endif  // NUMA_PARTITION_H_
@@ -0,0 +1,208 @@
+// Copyright (c) 2015, The Regents of the University of California (Regents)
+// See LICENSE.txt for license details
+
+#ifndef NUMA_PLACEMENT_H_
+#define NUMA_PLACEMENT_H_
+
+#include <numa.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+/*
+GAP Benchmark Suite
+File:   NUMA Placement
+
+Chooses which NUMA nodes large arrays (CSR arrays, pvectors, SlidingQueue
+buffers) are placed on, instead of leaving it to first-touch
+ - Policy is set once for the process (-N on command line, see CLBase)
+ - first-touch (default) changes nothing
+ - interleave spreads pages round-robin over all nodes
+ - bind:<node> puts everything on one node (bind alone is node 0)
+ - partitioned splits each array into one contiguous piece per node with
+   CPUs (NUMACPUNodes), to match OpenMP static schedules with threads bound
+   in order to nodes (e.g. OMP_PROC_BIND=close), CSR neighbors are split by
+   vertex ranges, nodes with only memory (e.g. CXL) get no piece since no
+   thread can run there
+ - Placement is applied right after allocation (before pages are touched)
+   and only to the whole pages inside arrays of at least kNUMAMinBytes, so
+   neighboring small allocations are unaffected
+ - NUMANodeBytes reports the process's resident memory per node
+*/
+
+
+enum class NUMAPolicy { kFirstTouch, kInterleave, kBind, kPartitioned };
+
+struct NUMASettings {
+  NUMAPolicy policy = NUMAPolicy::kFirstTouch;
+  int bind_node = 0;
+};
+
+static const size_t kNUMAMinBytes = 1 << 20;
+
+inline int NUMANumNodes() {
+  static const int num_nodes = numa_available() < 0 ? 1 :
+                               numa_max_node() + 1;
+  return num_nodes;
+}
+
+// Nodes that have CPUs, in order (node 0 alone if libnuma is unavailable)
+inline const std::vector<int>& NUMACPUNodes() {
+  static const std::vector<int> cpu_nodes = [] {
+    std::vector<int> nodes;
+    if (numa_available() >= 0) {
+      struct bitmask *cpus = numa_allocate_cpumask();
+      for (int node = 0; node < NUMANumNodes(); node++) {
+        if ((numa_node_to_cpus(node, cpus) == 0) &&
+            (numa_bitmask_weight(cpus) > 0))
+          nodes.push_back(node);
+      }
+      numa_free_cpumask(cpus);
+    }
+    if (nodes.empty())
+      nodes.push_back(0);
+    return nodes;
+  }();
+  return cpu_nodes;
+}
+
+inline NUMASettings& NUMAGlobalSettings() {
+  static NUMASettings settings;
+  return settings;
+}
+
+// Returns false if name isn't a recognized policy (or node doesn't exist)
+inline bool ParseNUMAPolicy(const std::string &name, NUMASettings *settings) {
+  if (name == "first-touch") {
+    settings->policy = NUMAPolicy::kFirstTouch;
+  } else if (name == "interleave") {
+    settings->policy = NUMAPolicy::kInterleave;
+  } else if (name == "partitioned") {
+    settings->policy = NUMAPolicy::kPartitioned;
+  } else if (name.compare(0, 4, "bind") == 0) {
+    settings->policy = NUMAPolicy::kBind;
+    settings->bind_node = 0;
+    if (name.size() > 4) {
+      if ((name[4] != ':') || (name.size() == 5) ||
+          (name.find_first_not_of("0123456789", 5) != std::string::npos))
+        return false;
+      settings->bind_node = std::atoi(name.c_str() + 5);
+    }
+    return settings->bind_node < NUMANumNodes();
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// Start of part's range when [0, num_items) is split into num_parts, parts
+// are equal except the last, which also gets the remainder
+inline int64_t NUMAPartStart(int64_t num_items, int part, int num_parts) {
+  if (part == num_parts)
+    return num_items;
+  return num_items / num_parts * part;
+}
+
+inline bool NUMAPlacementActive() {
+  return (NUMAGlobalSettings().policy != NUMAPolicy::kFirstTouch) &&
+         (numa_available() >= 0);
+}
+
+// Applies policy to whole pages in [begin, end), node -1 means interleave
+inline void NUMAPlaceRange(char *begin, char *end, int node) {
+  static const uintptr_t page_bytes = sysconf(_SC_PAGESIZE);
+  uintptr_t start = reinterpret_cast<uintptr_t>(begin);
+  start = (start + page_bytes - 1) / page_bytes * page_bytes;
+  uintptr_t stop = reinterpret_cast<uintptr_t>(end) / page_bytes * page_bytes;
+  if (stop <= start)
+    return;
+  void *pages = reinterpret_cast<void*>(start);
+  if (node == -1)
+    numa_interleave_memory(pages, stop - start, numa_all_nodes_ptr);
+  else
+    numa_tonode_memory(pages, stop - start, node);
+}
+
+// Places [ptr, ptr+num_bytes) by policy, if partitioned, part_ends are where
+// each CPU node's piece ends (evenly split if not given)
+inline void NUMAPlace(void *ptr, size_t num_bytes,
+                      const std::vector<size_t> &part_ends = {}) {
+  if ((ptr == nullptr) || (num_bytes < kNUMAMinBytes) ||
+      !NUMAPlacementActive())
+    return;
+  char *begin = static_cast<char*>(ptr);
+  const NUMASettings &settings = NUMAGlobalSettings();
+  switch (settings.policy) {
+    case NUMAPolicy::kInterleave:
+      NUMAPlaceRange(begin, begin + num_bytes, -1);
+      break;
+    case NUMAPolicy::kBind:
+      NUMAPlaceRange(begin, begin + num_bytes, settings.bind_node);
+      break;
+    case NUMAPolicy::kPartitioned: {
+      const std::vector<int> &nodes = NUMACPUNodes();
+      const int num_parts = nodes.size();
+      size_t part_start = 0;
+      for (int part = 0; part < num_parts; part++) {
+        size_t part_end = part_ends.empty() ?
+                          NUMAPartStart(num_bytes, part + 1, num_parts) :
+                          part_ends[part];
+        NUMAPlaceRange(begin + part_start, begin + part_end, nodes[part]);
+        part_start = part_end;
+      }
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+// Places neighbors array so if partitioned, each CPU node gets neighbors of
+// an equal range of vertices (offsets has num_vertices+1 entries)
+template <typename T_>
+void NUMAPlaceNeighs(T_ *neighs, const int64_t *offsets,
+                     int64_t num_vertices) {
+  if (!NUMAPlacementActive())
+    return;
+  const int num_parts = NUMACPUNodes().size();
+  std::vector<size_t> part_ends(num_parts);
+  for (int part = 0; part < num_parts; part++)
+    part_ends[part] = sizeof(T_) *
+                      offsets[NUMAPartStart(num_vertices, part + 1, num_parts)];
+  NUMAPlace(neighs, offsets[num_vertices] * sizeof(T_), part_ends);
+}
+
+// Resident bytes of this process on each node (from /proc/self/numa_maps)
+inline std::vector<int64_t> NUMANodeBytes() {
+  std::vector<int64_t> node_bytes(NUMANumNodes(), 0);
+  std::ifstream maps("/proc/self/numa_maps");
+  std::string line, token;
+  while (std::getline(maps, line)) {
+    std::istringstream tokens(line);
+    int64_t page_kb = 4;
+    std::vector<std::pair<int, int64_t>> line_pages;
+    while (tokens >> token) {
+      int node;
+      long long pages, kb;
+      if (std::sscanf(token.c_str(), "N%d=%lld", &node, &pages) == 2)
+        line_pages.emplace_back(node, pages);
+      else if (std::sscanf(token.c_str(), "kernelpagesize_kB=%lld", &kb) == 1)
+        page_kb = kb;
+    }
+    for (auto node_pages : line_pages) {
+      if (node_pages.first < static_cast<int>(node_bytes.size()))
+        node_bytes[node_pages.first] += node_pages.second * page_kb * 1024;
+    }
+  }
+  return node_bytes;
+}
+
+#endif  // NUMA_PLACEMENT_H_
@@ -38,6 +38,7 @@ pvector<ScoreT> PageRankPull(const Graph &g, int max_iters,
   const ScoreT base_score = (1.0f - kDamp) / g.num_nodes();
   pvector<ScoreT> scores(g.num_nodes(), init_score);
   pvector<ScoreT> outgoing_contrib(g.num_nodes());
+  g.PrepareInverse();
   for (int iter=0; iter < max_iters; iter++) {
     double error = 0;
     #pragma omp parallel for
@@ -5,6 +5,9 @@
 #define PVECTOR_H_
 
 #include <algorithm>
+#include <type_traits>
+
+#include "allocator.h"
 
 /*
 GAP Benchmark Suite
@@ -15,16 +18,19 @@ Vector class with ability to not initialize or do initialize in parallel
  - std::vector (when resizing) will always initialize, and does it serially
  - When pvector is resized, new elements are uninitialized
  - Resizing is not thread-safe
+ - Growing storage from new[] (NewAllocator) reallocs it in place
+ - Storage comes from an allocator policy (see allocator.h), by default the
+   one chosen on the command line
 */
 
-template <typename T_> class pvector {
+template <typename T_, class Alloc_ = RuntimeAllocator<T_>> class pvector {
 public:
   typedef T_ *iterator;
 
   pvector() : start_(nullptr), end_size_(nullptr), end_capacity_(nullptr) {}
 
   explicit pvector(size_t num_elements) {
-    start_ = new T_[num_elements];
+    start_ = alloc_.allocate(num_elements);
     // std::cout << "pvector start_: " << start_ << " ; "
     //           << static_cast<intptr_t>(reinterpret_cast<intptr_t>(start_))
     //           << "\n"
@@ -50,7 +56,7 @@ public:
   // prefer move because too much data to copy
   pvector(pvector &&other)
       : start_(other.start_), end_size_(other.end_size_),
-        end_capacity_(other.end_capacity_) {
+        end_capacity_(other.end_capacity_), alloc_(other.alloc_) {
     other.start_ = nullptr;
     other.end_size_ = nullptr;
     other.end_capacity_ = nullptr;
@@ -63,6 +69,7 @@ public:
       start_ = other.start_;
       end_size_ = other.end_size_;
       end_capacity_ = other.end_capacity_;
+      alloc_ = other.alloc_;
       other.start_ = nullptr;
       other.end_size_ = nullptr;
       other.end_capacity_ = nullptr;
@@ -72,7 +79,7 @@ public:
 
   void ReleaseResources() {
     if (start_ != nullptr) {
-      delete[] start_;
+      alloc_.deallocate(start_, capacity());
     }
   }
 
@@ -81,22 +88,33 @@ public:
   // not thread-safe
   void reserve(size_t num_elements) {
     if (num_elements > capacity()) {
-      T_ *new_range = new T_[num_elements];
+      if constexpr (kGrowsInPlace) {
+        size_t old_size = size();
+        start_ = alloc_.reallocate(start_, capacity(), num_elements);
+        end_size_ = start_ + old_size;
+      } else {
+        T_ *new_range = alloc_.allocate(num_elements);
 #pragma omp parallel for
-      for (size_t i = 0; i < size(); i++)
-        new_range[i] = start_[i];
-      end_size_ = new_range + size();
-      delete[] start_;
-      start_ = new_range;
+        for (size_t i = 0; i < size(); i++)
+          new_range[i] = start_[i];
+        end_size_ = new_range + size();
+        ReleaseResources();
+        start_ = new_range;
+      }
       end_capacity_ = start_ + num_elements;
     }
   }
 
   // prevents internal storage from being freed when this pvector is desctructed
   // - used by Builder to reuse an EdgeList's space for in-place graph building
-  void leak() { start_ = nullptr; }
+  // - only for storage from new[], since whoever takes it will use delete[]
+  void leak() {
+    static_assert(std::is_same<Alloc_, NewAllocator<T_>>::value,
+                  "only new[]'d storage can be leaked");
+    start_ = nullptr;
+  }
 
-  bool empty() { return end_size_ == start_; }
+  bool empty() const { return end_size_ == start_; }
 
   void clear() { end_size_ = start_; }
 
@@ -138,13 +156,55 @@ public:
     std::swap(start_, other.start_);
     std::swap(end_size_, other.end_size_);
     std::swap(end_capacity_, other.end_capacity_);
+    std::swap(alloc_, other.alloc_);
   }
 
 private:
   T_ *start_;
   T_ *end_size_;
   T_ *end_capacity_;
+  Alloc_ alloc_;
   static const size_t growth_factor = 2;
+  static constexpr bool kGrowsInPlace =
+      std::is_same<Alloc_, NewAllocator<T_>>::value &&
+      std::is_trivially_copyable<T_>::value;
 };
 
+
+// Exclusive prefix sum of counts, with the total appended (so it's one
+// longer), done by blocks in parallel
+template <typename T_, class Alloc_>
+pvector<int64_t> ParallelPrefixSum(const pvector<T_, Alloc_> &counts) {
+  const size_t block_size = 1 << 20;
+  const size_t num_blocks = (counts.size() + block_size - 1) / block_size;
+  pvector<int64_t> local_sums(num_blocks);
+#pragma omp parallel for
+  for (size_t block = 0; block < num_blocks; block++) {
+    int64_t lsum = 0;
+    size_t block_end = std::min((block + 1) * block_size, counts.size());
+    for (size_t i = block * block_size; i < block_end; i++)
+      lsum += counts[i];
+    local_sums[block] = lsum;
+  }
+  pvector<int64_t> bulk_prefix(num_blocks + 1);
+  int64_t total = 0;
+  for (size_t block = 0; block < num_blocks; block++) {
+    bulk_prefix[block] = total;
+    total += local_sums[block];
+  }
+  bulk_prefix[num_blocks] = total;
+  pvector<int64_t> prefix(counts.size() + 1);
+#pragma omp parallel for
+  for (size_t block = 0; block < num_blocks; block++) {
+    int64_t local_total = bulk_prefix[block];
+    size_t block_end = std::min((block + 1) * block_size, counts.size());
+    for (size_t i = block * block_size; i < block_end; i++) {
+      prefix[i] = local_total;
+      local_total += counts[i];
+    }
+  }
+  prefix[counts.size()] = bulk_prefix[num_blocks];
+  return prefix;
+}
+
 #endif // PVECTOR_H_
@@ -0,0 +1,352 @@
+// Copyright (c) 2015, The Regents of the University of California (Regents)
+// See LICENSE.txt for license details
+
+#ifndef RADIX_SORT_H_
+#define RADIX_SORT_H_
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+#include "pvector.h"
+
+
+/*
+GAP Benchmark Suite
+File:   Radix Sort
+
+Radix sorts that order elements by an unsigned integer key (from KeyFunc),
+used to sort edgelists, neighborhoods, and (degree, ID) pairs
+ - Key type can be any unsigned integer (including unsigned __int128), and
+   the key must order the same way the elements should be sorted
+ - Only digits (bytes) of the key that vary across the input are sorted on,
+   so e.g. vertex IDs of a small graph take fewer passes
+ - ParallelRadixSort is LSD (stable) and needs a temporary array as large as
+   the input, InPlaceRadixSort is MSD (not stable) and needs no extra space
+ - OrderedBits converts a signed or unsigned integer (or floating-point
+   number) to unsigned bits with the same order, for building keys out of
+   multiple fields
+*/
+
+
+template <typename T_>
+inline uint64_t OrderedBits(T_ x) {
+  if constexpr (std::is_floating_point<T_>::value) {
+    // negatives have their order reversed (sign-magnitude)
+    typedef typename std::conditional<sizeof(T_) == sizeof(uint32_t),
+                                      uint32_t, uint64_t>::type UnsignedT;
+    const UnsignedT sign = UnsignedT(1) << (8*sizeof(T_) - 1);
+    UnsignedT bits;
+    std::memcpy(&bits, &x, sizeof(T_));
+    return (bits & sign) ? ~bits : (bits | sign);
+  } else {
+    typedef typename std::make_unsigned<T_>::type UnsignedT;
+    UnsignedT bits = static_cast<UnsignedT>(x);
+    if (std::is_signed<T_>::value)
+      bits ^= UnsignedT(1) << (8*sizeof(T_) - 1);
+    return bits;
+  }
+}
+
+namespace radix_internal {
+
+static const int kDigitBits = 8;
+static const int kRadix = 1 << kDigitBits;
+static const int64_t kSmallSort = 64;
+
+inline int64_t NumBlocks(size_t n) {
+  int64_t num_blocks = 1;
+  #ifdef _OPENMP
+    num_blocks = omp_get_max_threads();
+  #endif
+  const size_t min_block_size = 1 << 14;
+  return std::max(int64_t(1), std::min(num_blocks,
+                                       int64_t(n / min_block_size)));
+}
+
+// Bits of key that differ from those of the first element
+template <typename T_, typename KeyFunc>
+auto VaryingBits(const T_ *data, size_t n, KeyFunc key, bool parallel)
+    -> decltype(key(*data)) {
+  typedef decltype(key(*data)) KeyT;
+  if (n == 0)
+    return KeyT(0);
+  const KeyT first = key(data[0]);
+  const int64_t num_blocks = parallel ? NumBlocks(n) : 1;
+  const size_t block_size = (n + num_blocks - 1) / num_blocks;
+  pvector<KeyT> block_varying(num_blocks);
+  #pragma omp parallel for if (parallel)
+  for (int64_t b = 0; b < num_blocks; b++) {
+    KeyT varying = 0;
+    for (size_t i = b * block_size; i < std::min(n, (b+1) * block_size); i++)
+      varying |= key(data[i]) ^ first;
+    block_varying[b] = varying;
+  }
+  KeyT varying = 0;
+  for (int64_t b = 0; b < num_blocks; b++)
+    varying |= block_varying[b];
+  return varying;
+}
+
+template <typename KeyT>
+inline int TopDigitShift(KeyT varying) {
+  int shift = 0;
+  while ((shift + kDigitBits < int(8*sizeof(KeyT))) &&
+         ((varying >> (shift + kDigitBits)) != 0))
+    shift += kDigitBits;
+  return shift;
+}
+
+template <typename T_, typename KeyFunc>
+void SmallSort(T_ *begin, T_ *end, KeyFunc key) {
+  std::sort(begin, end, [&key](const T_ &a, const T_ &b) {
+    return key(a) < key(b);
+  });
+}
+
+// Moves elements within the ranges [next[d], ends[d]) so each range only
+// holds digit d (American flag sort), together the ranges must hold exactly
+// as many elements of each digit as that digit's range has room for
+template <typename T_, typename KeyFunc>
+void PermuteInPlace(T_ *begin, KeyFunc key, int shift, int64_t *next,
+                    const int64_t *ends) {
+  for (int d = 0; d < kRadix; d++) {
+    while (next[d] < ends[d]) {
+      T_ x = begin[next[d]];
+      int digit = static_cast<int>((key(x) >> shift) & (kRadix - 1));
+      while (digit != d) {
+        std::swap(x, begin[next[digit]++]);
+        digit = static_cast<int>((key(x) >> shift) & (kRadix - 1));
+      }
+      begin[next[d]++] = x;
+    }
+  }
+}
+
+// Permutes [begin, end) in place so elements are grouped by digit at shift
+// (American flag sort), bucket_ends[d] is where digit d's elements end
+template <typename T_, typename KeyFunc>
+void DistributeInPlace(T_ *begin, KeyFunc key, int shift,
+                       const int64_t *counts, int64_t *bucket_ends) {
+  int64_t next[kRadix];
+  int64_t pos = 0;
+  for (int d = 0; d < kRadix; d++) {
+    next[d] = pos;
+    pos += counts[d];
+    bucket_ends[d] = pos;
+  }
+  PermuteInPlace(begin, key, shift, next, bucket_ends);
+}
+
+// Same as DistributeInPlace, but with num_threads threads (as in PARADIS),
+// in rounds until too few elements are left unplaced to split:
+//  - what's left of each bucket is split into a stripe per thread, and each
+//    thread permutes among its own stripes, so an element whose stripe is
+//    full is left at the back of the stripe it was taken from
+//  - each bucket is repaired (buckets in parallel) by swapping its placed
+//    elements to its front, ahead of those left unplaced
+// and the rest are then placed serially
+template <typename T_, typename KeyFunc>
+void ParallelDistributeInPlace(T_ *begin, KeyFunc key, int shift,
+                               const int64_t *counts, int64_t *bucket_ends,
+                               int64_t num_threads) {
+  int64_t heads[kRadix];
+  int64_t pos = 0;
+  for (int d = 0; d < kRadix; d++) {
+    heads[d] = pos;
+    pos += counts[d];
+    bucket_ends[d] = pos;
+  }
+  pvector<int64_t> starts(num_threads * kRadix);
+  pvector<int64_t> placed(num_threads * kRadix);
+  pvector<int64_t> stops(num_threads * kRadix);
+  int64_t unplaced = pos, last_unplaced = -1;
+  while ((unplaced != last_unplaced) && (NumBlocks(unplaced) > 1)) {
+    for (int d = 0; d < kRadix; d++) {
+      const int64_t len = bucket_ends[d] - heads[d];
+      for (int64_t t = 0; t < num_threads; t++) {
+        starts[t * kRadix + d] = heads[d] + len * t / num_threads;
+        stops[t * kRadix + d] = heads[d] + len * (t+1) / num_threads;
+        placed[t * kRadix + d] = starts[t * kRadix + d];
+      }
+    }
+    #pragma omp parallel for schedule(static, 1)
+    for (int64_t t = 0; t < num_threads; t++) {
+      int64_t *next = placed.data() + t * kRadix;
+      const int64_t *stop = stops.data() + t * kRadix;
+      for (int d = 0; d < kRadix; d++) {
+        // [start, next[d]) placed and [next[d], head) left unplaced
+        int64_t head = next[d];
+        while (head < stop[d]) {
+          T_ x = begin[head];
+          int digit = static_cast<int>((key(x) >> shift) & (kRadix - 1));
+          while ((digit != d) && (next[digit] < stop[digit])) {
+            std::swap(x, begin[next[digit]++]);
+            digit = static_cast<int>((key(x) >> shift) & (kRadix - 1));
+          }
+          if (digit == d) {
+            begin[head++] = begin[next[d]];
+            begin[next[d]++] = x;
+          } else {
+            begin[head++] = x;
+          }
+        }
+      }
+    }
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int d = 0; d < kRadix; d++) {
+      int64_t num_placed = 0;
+      for (int64_t t = 0; t < num_threads; t++)
+        num_placed += placed[t * kRadix + d] - starts[t * kRadix + d];
+      const int64_t mid = heads[d] + num_placed;
+      // unplaced before mid swap with placed at or after mid (from back)
+      int64_t back_t = num_threads - 1;
+      int64_t back = placed[back_t * kRadix + d];
+      for (int64_t t = 0; t < num_threads; t++) {
+        const int64_t front_end = std::min(stops[t * kRadix + d], mid);
+        for (int64_t i = placed[t * kRadix + d]; i < front_end; i++) {
+          while (back <= std::max(starts[back_t * kRadix + d], mid)) {
+            back_t--;
+            back = placed[back_t * kRadix + d];
+          }
+          std::swap(begin[i], begin[--back]);
+        }
+      }
+      heads[d] = mid;
+    }
+    last_unplaced = unplaced;
+    unplaced = 0;
+    for (int d = 0; d < kRadix; d++)
+      unplaced += bucket_ends[d] - heads[d];
+  }
+  PermuteInPlace(begin, key, shift, heads, bucket_ends);
+}
+
+template <typename T_, typename KeyFunc>
+void MSDRadixSort(T_ *begin, T_ *end, KeyFunc key, int shift) {
+  const int64_t n = end - begin;
+  if (n <= kSmallSort) {
+    SmallSort(begin, end, key);
+    return;
+  }
+  int64_t counts[kRadix] = {};
+  for (T_ *it = begin; it < end; it++)
+    counts[(key(*it) >> shift) & (kRadix - 1)]++;
+  int64_t bucket_ends[kRadix];
+  if (*std::max_element(counts, counts + kRadix) != n) {
+    DistributeInPlace(begin, key, shift, counts, bucket_ends);
+  } else {
+    std::fill(bucket_ends, bucket_ends + kRadix, n);
+  }
+  if (shift == 0)
+    return;
+  int64_t bucket_start = 0;
+  for (int d = 0; d < kRadix; d++) {
+    if (bucket_ends[d] - bucket_start > 1)
+      MSDRadixSort(begin + bucket_start, begin + bucket_ends[d], key,
+                   shift - kDigitBits);
+    bucket_start = bucket_ends[d];
+  }
+}
+
+}  // namespace radix_internal
+
+
+// Sorts [begin, end) in place without extra space, counting and distributing
+// by top digit and sorting the resulting buckets are done in parallel if
+// parallel
+template <typename T_, typename KeyFunc>
+void InPlaceRadixSort(T_ *begin, T_ *end, KeyFunc key, bool parallel = true) {
+  using namespace radix_internal;
+  const int64_t n = end - begin;
+  if (n <= kSmallSort) {
+    SmallSort(begin, end, key);
+    return;
+  }
+  auto varying = VaryingBits(begin, n, key, parallel);
+  if (varying == 0)
+    return;
+  const int shift = TopDigitShift(varying);
+  if (!parallel) {
+    MSDRadixSort(begin, end, key, shift);
+    return;
+  }
+  const int64_t num_blocks = NumBlocks(n);
+  const int64_t block_size = (n + num_blocks - 1) / num_blocks;
+  pvector<int64_t> block_counts(num_blocks * kRadix, 0);
+  #pragma omp parallel for
+  for (int64_t b = 0; b < num_blocks; b++) {
+    int64_t *local = block_counts.data() + b * kRadix;
+    for (int64_t i = b * block_size; i < std::min(n, (b+1) * block_size); i++)
+      local[(key(begin[i]) >> shift) & (kRadix - 1)]++;
+  }
+  int64_t counts[kRadix] = {};
+  for (int64_t b = 0; b < num_blocks; b++)
+    for (int d = 0; d < kRadix; d++)
+      counts[d] += block_counts[b * kRadix + d];
+  int64_t bucket_ends[kRadix];
+  ParallelDistributeInPlace(begin, key, shift, counts, bucket_ends,
+                            num_blocks);
+  if (shift == 0)
+    return;
+  #pragma omp parallel for schedule(dynamic, 1)
+  for (int d = 0; d < kRadix; d++) {
+    int64_t bucket_start = d == 0 ? 0 : bucket_ends[d-1];
+    if (bucket_ends[d] - bucket_start > 1)
+      MSDRadixSort(begin + bucket_start, begin + bucket_ends[d], key,
+                   shift - kDigitBits);
+  }
+}
+
+
+// Stable sort of data[0, n) with all threads, uses temp[0, n) as scratch
+template <typename T_, typename KeyFunc>
+void ParallelRadixSort(T_ *data, T_ *temp, size_t n, KeyFunc key) {
+  using namespace radix_internal;
+  auto varying = VaryingBits(data, n, key, true);
+  const int64_t num_blocks = NumBlocks(n);
+  const size_t block_size = (n + num_blocks - 1) / num_blocks;
+  pvector<size_t> block_starts(num_blocks * kRadix);
+  T_ *src = data, *dst = temp;
+  for (int shift = 0; (shift < int(8*sizeof(varying))) &&
+                      ((varying >> shift) != 0); shift += kDigitBits) {
+    if (((varying >> shift) & (kRadix - 1)) == 0)
+      continue;
+    #pragma omp parallel for
+    for (int64_t b = 0; b < num_blocks; b++) {
+      size_t *local = block_starts.data() + b * kRadix;
+      std::fill(local, local + kRadix, 0);
+      for (size_t i = b * block_size; i < std::min(n, (b+1) * block_size); i++)
+        local[(key(src[i]) >> shift) & (kRadix - 1)]++;
+    }
+    // ordered by digit then block, so output is stable
+    size_t total = 0;
+    for (int d = 0; d < kRadix; d++) {
+      for (int64_t b = 0; b < num_blocks; b++) {
+        size_t count = block_starts[b * kRadix + d];
+        block_starts[b * kRadix + d] = total;
+        total += count;
+      }
+    }
+    #pragma omp parallel for
+    for (int64_t b = 0; b < num_blocks; b++) {
+      size_t *next = block_starts.data() + b * kRadix;
+      for (size_t i = b * block_size; i < std::min(n, (b+1) * block_size); i++)
+        dst[next[(key(src[i]) >> shift) & (kRadix - 1)]++] = src[i];
+    }
+    std::swap(src, dst);
+  }
+  if (src != data) {
+    #pragma omp parallel for
+    for (size_t i = 0; i < n; i++)
+      data[i] = src[i];
+  }
+}
+
+#endif  // RADIX_SORT_H_
@@ -4,13 +4,27 @@
 #ifndef READER_H_
 #define READER_H_
 
+#include <cmath>
+#include <cstring>
 #include <iostream>
 #include <fstream>
+#include <limits>
+#include <memory>
 #include <sstream>
 #include <string>
 #include <type_traits>
+#include <vector>
 
+#include "allocator.h"
+#include "bel_format.h"
+#include "compressed_file.h"
+#include "compressed_graph.h"
+#include "mapped_file.h"
+#include "numa_placement.h"
 #include "pvector.h"
+#include "sg_format.h"
+#include "split_graph.h"
+#include "text_parser.h"
 #include "util.h"
 
 
@@ -24,20 +38,77 @@ Given filename, returns an edgelist or the entire graph (if serialized)
  - Determines file format from the filename's suffix
  - If the input graph is serialized (.sg or .wsg), reads the graph
    directly into the returned graph instance
+ - Serialized graphs can be either format version (see sg_format.h)
+ - Serialized graphs can also be memory-mapped (MapSerializedGraph), so the
+   returned graph uses the file's pages in place instead of copies of them
+ - Weighted serialized graphs store weights apart from neighbors, which are
+   interleaved into a CSRGraph, or loaded as they are into a SplitCSRGraph
+   (LoadSplitGraph)
  - Otherwise, reads the file and returns an edgelist
+ - Text formats are memory-mapped and parsed by all threads in parallel
+   (see text_parser.h), binary edge lists are copied or converted in parallel
+ - Compressed text formats (e.g. graph.el.gz) are parsed a block at a time
+   while the next block is decompressed (see compressed_file.h)
+ - Edge lists with IDs too big for NodeID_ are noted (ids_too_wide), so the
+   builder can rerun with 64-bit IDs (see id_width.h)
 */
 
 
 template <typename NodeID_, typename DestID_ = NodeID_,
-          typename WeightT_ = NodeID_, bool invert = true>
+          typename WeightT_ = NodeID_, bool invert = true,
+          bool lazy_inverse = false>
 class Reader {
   typedef EdgePair<NodeID_, DestID_> Edge;
-  typedef pvector<Edge> EdgeList;
+  typedef pvector<Edge, NewAllocator<Edge>> EdgeList;
+  typedef CSRGraph<NodeID_, DestID_, invert, lazy_inverse> CSRGraphT;
+  typedef typename CSRGraphT::Index Index;
   std::string filename_;
+  bool ids_too_wide_ = false;
+  bool weights_out_of_range_ = false;
 
  public:
   explicit Reader(std::string filename) : filename_(filename) {}
 
+  // Whether edges read had IDs too big for NodeID_ (see id_width.h)
+  bool ids_too_wide() const { return ids_too_wide_; }
+
+  // Like ParseInt, but notes IDs too big for NodeID_ instead of wrapping,
+  // including its max, since then the number of vertices wouldn't fit
+  const char* ParseID(const char *p, const char *end, NodeID_ &id) {
+    int64_t wide_id;
+    if (!(p = ParseInt(p, end, wide_id)))
+      return nullptr;
+    if (wide_id >= std::numeric_limits<NodeID_>::max()) {
+      #pragma omp atomic write
+      ids_too_wide_ = true;
+    }
+    id = static_cast<NodeID_>(wide_id);
+    return p;
+  }
+
+  // Like ParseNumber, but notes weights out of WeightT_'s range instead of
+  // wrapping (ReadFile then exits)
+  const char* ParseWeight(const char *p, const char *end, WeightT_ &w) {
+    typedef typename std::conditional<std::is_floating_point<WeightT_>::value,
+                                      double, int64_t>::type WideT;
+    WideT wide_w;
+    if (!(p = ParseNumber(p, end, wide_w)))
+      return nullptr;
+    bool in_range;
+    if constexpr (std::is_floating_point<WeightT_>::value)
+      in_range = std::isnan(wide_w) || std::isinf(wide_w) ||
+                 (std::abs(wide_w) <= std::numeric_limits<WeightT_>::max());
+    else
+      in_range = (wide_w >= std::numeric_limits<WeightT_>::min()) &&
+                 (wide_w <= std::numeric_limits<WeightT_>::max());
+    if (!in_range) {
+      #pragma omp atomic write
+      weights_out_of_range_ = true;
+    }
+    w = static_cast<WeightT_>(wide_w);
+    return p;
+  }
+
   std::string GetSuffix() {
     std::size_t suff_pos = filename_.rfind('.');
     if (suff_pos == std::string::npos) {
@@ -47,107 +118,177 @@ class Reader {
     return filename_.substr(suff_pos);
   }
 
-  EdgeList ReadInEL(std::ifstream &in) {
-    EdgeList el;
-    NodeID_ u, v;
-    while (in >> u >> v) {
-      el.push_back(Edge(u, v));
-    }
-    return el;
+  // Formats with optional weights fill them in only if read (the builder
+  // inserts them otherwise), unweighted edges drop them
+  static Edge MakeEdge(NodeID_ u, NodeWeight<NodeID_, WeightT_> v,
+                       bool read_weights) {
+    if (read_weights || std::is_same<NodeID_, DestID_>::value)
+      return Edge(u, DestID_(v));
+    return Edge(u, DestID_(v.v));
   }
 
-  EdgeList ReadInWEL(std::ifstream &in) {
-    EdgeList el;
-    NodeID_ u;
-    NodeWeight<NodeID_, WeightT_> v;
-    while (in >> u >> v) {
-      el.push_back(Edge(u, v));
-    }
-    return el;
+  void ReadInEL(const char *begin, const char *end, EdgeList &el) {
+    auto parse_edge = [this](const char *p, const char *line_end, Edge *out) {
+      NodeID_ u, v;
+      if (!(p = ParseID(p, line_end, u)) || !ParseID(p, line_end, v))
+        return -1;
+      *out = Edge(u, v);
+      return 1;
+    };
+    ParseLines(begin, end, 1, parse_edge, el);
+  }
+
+  void ReadInWEL(const char *begin, const char *end, EdgeList &el) {
+    auto parse_edge = [this](const char *p, const char *line_end, Edge *out) {
+      NodeID_ u;
+      NodeWeight<NodeID_, WeightT_> v;
+      if (!(p = ParseID(p, line_end, u)) || !(p = ParseID(p, line_end, v.v))
+          || !ParseWeight(p, line_end, v.w))
+        return -1;
+      *out = Edge(u, v);
+      return 1;
+    };
+    ParseLines(begin, end, 1, parse_edge, el);
   }
 
   // Note: converts vertex numbering from 1..N to 0..N-1
-  EdgeList ReadInGR(std::ifstream &in) {
-    EdgeList el;
-    char c;
-    NodeID_ u;
-    NodeWeight<NodeID_, WeightT_> v;
-    while (!in.eof()) {
-      c = in.peek();
-      if (c == 'a') {
-        in >> c >> u >> v;
-        el.push_back(Edge(u - 1, NodeWeight<NodeID_, WeightT_>(v.v-1, v.w)));
-      } else {
-        in.ignore(200, '\n');
+  void ReadInGR(const char *begin, const char *end, EdgeList &el) {
+    auto parse_arc = [this](const char *p, const char *line_end, Edge *out) {
+      if (*p != 'a')
+        return 0;
+      NodeID_ u;
+      NodeWeight<NodeID_, WeightT_> v;
+      if (!(p = ParseID(p + 1, line_end, u)) ||
+          !(p = ParseID(p, line_end, v.v)) || !ParseWeight(p, line_end, v.w))
+        return -1;
+      *out = Edge(u - 1, NodeWeight<NodeID_, WeightT_>(v.v-1, v.w));
+      return 1;
+    };
+    ParseLines(begin, end, 1, parse_arc, el);
+  }
+
+  // Settings from a text format's header needed to parse the rest of it
+  struct TextHeader {
+    bool read_weights = false;
+    bool undirected = false;  // .mtx symmetric entries are added both ways
+    int64_t num_nodes = 0;    // .graph only uses this many vertex lines
+    int64_t next_node = 0;    // .graph vertex of the next line to be parsed
+  };
+
+  // Returns start of body (after header)
+  const char* ReadMetisHeader(const char *begin, const char *end,
+                              TextHeader &header) {
+    const char *p = begin;
+    while ((p < end) && IsCommentLine(p, FindLineEnd(p, end)))
+      p = FindLineEnd(p, end) + 1;
+    p = std::min(p, end);
+    const char *header_line = p;
+    const char *header_end = FindLineEnd(p, end);
+    int64_t num_nodes, num_edges;
+    if (!(p = ParseInt(p, header_end, num_nodes)) ||
+        !(p = ParseInt(p, header_end, num_edges)))
+      ExitMalformedLine(header_line, end);
+    int32_t fmt;
+    if (ParseInt(p, header_end, fmt)) {
+      if (fmt == 1) {
+        header.read_weights = true;
+      } else if ((fmt != 0) && (fmt != 100)) {
+        std::cout << "Do not support METIS fmt type: " << fmt << std::endl;
+        std::exit(-20);
       }
     }
-    return el;
+    if (num_nodes > std::numeric_limits<NodeID_>::max())
+      ids_too_wide_ = true;
+    header.num_nodes = num_nodes;
+    header.next_node = 0;
+    return std::min(header_end + 1, end);
   }
 
   // Note: converts vertex numbering from 1..N to 0..N-1
-  EdgeList ReadInMetis(std::ifstream &in, bool &needs_weights) {
-    EdgeList el;
-    NodeID_ num_nodes, num_edges;
-    char c;
-    std::string line;
-    bool read_weights = false;
-    while (true) {
-      c = in.peek();
-      if (c == '%') {
-        in.ignore(200, '\n');
-      } else {
-        std::getline(in, line, '\n');
-        std::istringstream header_stream(line);
-        header_stream >> num_nodes >> num_edges;
-        header_stream >> std::ws;
-        if (!header_stream.eof()) {
-          int32_t fmt;
-          header_stream >> fmt;
-          if (fmt == 1) {
-            read_weights = true;
-          } else if ((fmt != 0) && (fmt != 100)) {
-            std::cout << "Do not support METIS fmt type: " << fmt << std::endl;
-            std::exit(-20);
-          }
+  // Each non-comment line after the header (even if empty) is the adjacency
+  // of the next vertex, so in parallel each chunk first counts its vertices
+  // and edges to know which vertex it starts at and where to write edges
+  void ReadMetisBody(const char *begin, const char *end, TextHeader &header,
+                     EdgeList &el) {
+    const bool read_weights = header.read_weights;
+    const int64_t num_nodes = header.num_nodes;
+    const int num_chunks = DefaultNumChunks(end - begin);
+    std::vector<const char*> bounds = SplitAtNewlines(begin, end, num_chunks);
+    const int tokens_per_edge = read_weights ? 2 : 1;
+    pvector<int64_t> chunk_nodes(num_chunks + 1), chunk_edges(num_chunks + 1);
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int c = 0; c < num_chunks; c++) {
+      int64_t nodes = 0, edges = 0;
+      for (const char *line = bounds[c]; line < bounds[c+1];) {
+        const char *line_end = FindLineEnd(line, bounds[c+1]);
+        if (!IsCommentLine(line, line_end)) {
+          nodes++;
+          edges += CountTokens(line, line_end) / tokens_per_edge;
         }
-        break;
+        line = line_end + 1;
       }
+      chunk_nodes[c] = nodes;
+      chunk_edges[c] = edges;
     }
-    NodeID_ u = 0;
-    while (u < num_nodes) {
-      c = in.peek();
-      if (c == '%') {
-        in.ignore(200, '\n');
-      } else {
-        std::getline(in, line);
-        if (line != "") {
-          std::istringstream edge_stream(line);
-          if (read_weights) {
-            NodeWeight<NodeID_, WeightT_> v;
-            while (edge_stream >> v >> std::ws) {
-              v.v -= 1;
-              el.push_back(Edge(u, v));
-            }
-          } else {
-            NodeID_ v;
-            while (edge_stream >> v >> std::ws) {
-              el.push_back(Edge(u, v - 1));
+    const int64_t num_before = el.size();
+    int64_t total_nodes = header.next_node, total_edges = num_before;
+    for (int c = 0; c <= num_chunks; c++) {
+      int64_t nodes = chunk_nodes[c], edges = chunk_edges[c];
+      chunk_nodes[c] = total_nodes;
+      chunk_edges[c] = total_edges;
+      if (c < num_chunks) {
+        total_nodes += nodes;
+        total_edges += edges;
+      }
+    }
+    header.next_node = total_nodes;
+    el.resize(total_edges);
+    pvector<int64_t> chunk_written(num_chunks);
+    const char *malformed = nullptr;
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int c = 0; c < num_chunks; c++) {
+      int64_t u = chunk_nodes[c];
+      Edge *out = el.data() + chunk_edges[c];
+      for (const char *line = bounds[c];
+           (line < bounds[c+1]) && (u < num_nodes);) {
+        const char *line_end = FindLineEnd(line, bounds[c+1]);
+        if (!IsCommentLine(line, line_end)) {
+          NodeWeight<NodeID_, WeightT_> v(0);
+          const char *q = line;
+          while ((q = SkipLineSpace(q, line_end)) != line_end) {
+            if (!(q = ParseID(q, line_end, v.v)) ||
+                (read_weights && !(q = ParseWeight(q, line_end, v.w)))) {
+              #pragma omp critical
+              if ((malformed == nullptr) || (line < malformed))
+                malformed = line;
+              break;
             }
+            v.v -= 1;
+            *(out++) = MakeEdge(u, v, read_weights);
           }
+          u++;
         }
-        u++;
+        line = line_end + 1;
       }
+      chunk_written[c] = out - (el.data() + chunk_edges[c]);
     }
-    needs_weights = !read_weights;
-    return el;
+    if (malformed != nullptr)
+      ExitMalformedLine(malformed, end);
+    // only lines of the first num_nodes vertices are used, so any unused
+    // space is at the end
+    int64_t num_written = num_before;
+    for (int c = 0; c < num_chunks; c++)
+      num_written += chunk_written[c];
+    el.resize(num_written);
   }
 
-  // Note: converts vertex numbering from 1..N to 0..N-1
-  // Note: weights casted to type WeightT_
-  EdgeList ReadInMTX(std::ifstream &in, bool &needs_weights) {
-    EdgeList el;
-    std::string start, object, format, field, symmetry, line;
-    in >> start >> object >> format >> field >> symmetry >> std::ws;
+  // Returns start of body (after banner, comments, and size line)
+  const char* ReadMTXHeader(const char *begin, const char *end,
+                            TextHeader &header) {
+    std::string start, object, format, field, symmetry;
+    const char *banner_end = FindLineEnd(begin, end);
+    std::istringstream banner(std::string(begin, banner_end));
+    banner >> start >> object >> format >> field >> symmetry;
     if (start != "%%MatrixMarket") {
       std::cout << ".mtx file did not start with %%MatrixMarket" << std::endl;
       std::exit(-21);
@@ -160,61 +301,212 @@ class Reader {
       std::cout << "do not support complex weights for .mtx" << std::endl;
       std::exit(-23);
     }
-    bool read_weights;
     if (field == "pattern") {
-      read_weights = false;
+      header.read_weights = false;
     } else if ((field == "real") || (field == "double") ||
                (field == "integer")) {
-      read_weights = true;
+      header.read_weights = true;
     } else {
       std::cout << "unrecognized field type for .mtx" << std::endl;
       std::exit(-24);
     }
-    bool undirected;
     if (symmetry == "symmetric") {
-      undirected = true;
+      header.undirected = true;
     } else if ((symmetry == "general") || (symmetry == "skew-symmetric")) {
-      undirected = false;
+      header.undirected = false;
     } else {
       std::cout << "unsupported symmetry type for .mtx" << std::endl;
       std::exit(-25);
     }
-    while (true) {
-      char c = in.peek();
-      if (c == '%') {
-        in.ignore(200, '\n');
-      } else {
+    // skip comments & blank lines to get to size line
+    const char *p = std::min(banner_end + 1, end);
+    while (p < end) {
+      const char *line_end = FindLineEnd(p, end);
+      if ((SkipLineSpace(p, line_end) != line_end) &&
+          !IsCommentLine(p, line_end))
         break;
-      }
+      p = line_end + 1;
     }
+    p = std::min(p, end);
+    const char *size_line = p;
+    const char *size_end = FindLineEnd(p, end);
     int64_t m, n, nonzeros;
-    in >> m >> n >> nonzeros >> std::ws;
+    if (!(p = ParseInt(p, size_end, m)) || !(p = ParseInt(p, size_end, n)) ||
+        !ParseInt(p, size_end, nonzeros))
+      ExitMalformedLine(size_line, end);
     if (m != n) {
       std::cout << m << " " << n << " " << nonzeros << std::endl;
       std::cout << "matrix must be square for .mtx" << std::endl;
       std::exit(-26);
     }
-    while (std::getline(in, line)) {
-      if (line.empty())
-        continue;
-      std::istringstream edge_stream(line);
+    return std::min(size_end + 1, end);
+  }
+
+  // Note: converts vertex numbering from 1..N to 0..N-1
+  // Note: weights casted to type WeightT_
+  void ReadMTXBody(const char *begin, const char *end,
+                   const TextHeader &header, EdgeList &el) {
+    const bool read_weights = header.read_weights;
+    const bool undirected = header.undirected;
+    auto parse_entry = [this, read_weights, undirected](
+        const char *p, const char *line_end, Edge *out) {
       NodeID_ u;
-      edge_stream >> u;
-      if (read_weights) {
-        NodeWeight<NodeID_, WeightT_> v;
-        edge_stream >> v;
-        v.v -= 1;
-        el.push_back(Edge(u - 1, v));
-        if (undirected)
-          el.push_back(Edge(v.v, NodeWeight<NodeID_, WeightT_>(u - 1, v.w)));
-      } else {
-        NodeID_ v;
-        edge_stream >> v;
-        el.push_back(Edge(u - 1, v - 1));
-        if (undirected)
-          el.push_back(Edge(v - 1, u - 1));
+      NodeWeight<NodeID_, WeightT_> v(0);
+      if (!(p = ParseID(p, line_end, u)) || !(p = ParseID(p, line_end, v.v))
+          || (read_weights && !ParseWeight(p, line_end, v.w)))
+        return -1;
+      u -= 1;
+      v.v -= 1;
+      out[0] = MakeEdge(u, v, read_weights);
+      if (!undirected)
+        return 1;
+      out[1] = MakeEdge(v.v, NodeWeight<NodeID_, WeightT_>(u, v.w),
+                        read_weights);
+      return 2;
+    };
+    ParseLines(begin, end, undirected ? 2 : 1, parse_entry, el);
+  }
+
+  static bool IsTextFormat(std::string suffix) {
+    return (suffix == ".el") || (suffix == ".wel") || (suffix == ".gr") ||
+           (suffix == ".graph") || (suffix == ".mtx");
+  }
+
+  // Returns start of body (after header if format has one)
+  const char* ReadTextHeader(std::string suffix, const char *begin,
+                             const char *end, TextHeader &header) {
+    if (suffix == ".graph")
+      return ReadMetisHeader(begin, end, header);
+    if (suffix == ".mtx")
+      return ReadMTXHeader(begin, end, header);
+    header.read_weights = (suffix == ".wel") || (suffix == ".gr");
+    return begin;
+  }
+
+  // Appends edges to el, body can be given all at once or as consecutive
+  // ranges of whole lines
+  void ReadTextBody(std::string suffix, const char *begin, const char *end,
+                    TextHeader &header, EdgeList &el) {
+    if (suffix == ".el")
+      ReadInEL(begin, end, el);
+    else if (suffix == ".wel")
+      ReadInWEL(begin, end, el);
+    else if (suffix == ".gr")
+      ReadInGR(begin, end, el);
+    else if (suffix == ".graph")
+      ReadMetisBody(begin, end, header, el);
+    else
+      ReadMTXBody(begin, end, header, el);
+  }
+
+  // Decompression (see compressed_file.h) runs in the background while each
+  // block of lines is parsed and appended to the same EdgeList, which grows
+  // in place (see NewAllocator) so edges are never held twice
+  EdgeList ReadInCompressed(std::string suffix, TextHeader &header) {
+    std::string inner = filename_.substr(0, filename_.size()-suffix.size());
+    std::size_t suff_pos = inner.rfind('.');
+    std::string text_suffix = suff_pos == std::string::npos ? "" :
+                              inner.substr(suff_pos);
+    if (!IsTextFormat(text_suffix)) {
+      std::cout << "Unrecognized suffix: " << text_suffix << suffix
+                << std::endl;
+      std::exit(-3);
+    }
+    CompressedFile file(filename_);
+    EdgeList el;
+    const char *begin, *end;
+    for (bool first = true; file.NextBlock(&begin, &end); first = false) {
+      if (first)
+        begin = ReadTextHeader(text_suffix, begin, end, header);
+      ReadTextBody(text_suffix, begin, end, header, el);
+    }
+    return el;
+  }
+
+  static int64_t ReadBELID(const char *record, uint32_t id_bytes) {
+    if (id_bytes == sizeof(int32_t)) {
+      int32_t id;
+      std::memcpy(&id, record, sizeof(int32_t));
+      return id;
+    }
+    int64_t id;
+    std::memcpy(&id, record, sizeof(int64_t));
+    return id;
+  }
+
+  // Binary edge list (see bel_format.h) is copied straight into the
+  // EdgeList in parallel if its records have the same layout as Edge,
+  // otherwise each record is converted in parallel, either way IDs are
+  // checked (negative or too wide) before they are used as indices
+  EdgeList ReadInBEL(const char *begin, const char *end,
+                     bool &needs_weights) {
+    BELHeader header;
+    if (static_cast<size_t>(end - begin) < sizeof(BELHeader)) {
+      std::cout << "Truncated binary edge list " << filename_ << std::endl;
+      std::exit(-7);
+    }
+    std::memcpy(&header, begin, sizeof(BELHeader));
+    if (!BELHasMagic(header) || (header.version != kBELVersion)) {
+      std::cout << filename_ << " is not a binary edge list" << std::endl;
+      std::exit(-9);
+    }
+    if ((header.id_bytes != sizeof(int32_t)) &&
+        (header.id_bytes != sizeof(int64_t))) {
+      std::cout << "Unsupported ID width: " << header.id_bytes << std::endl;
+      std::exit(-9);
+    }
+    bool read_weights = header.weight_bytes != 0;
+    if (read_weights && ((header.weight_bytes != sizeof(WeightT_)) ||
+                         (header.weight_kind != SGWeightKindOf<WeightT_>()))) {
+      std::cout << "Binary edge list has "
+                << SGWeightName(header.weight_kind, header.weight_bytes)
+                << " weights but expected "
+                << SGWeightName(SGWeightKindOf<WeightT_>(), sizeof(WeightT_))
+                << std::endl;
+      std::exit(-9);
+    }
+    const size_t record_bytes = header.record_bytes();
+    const char *records = begin + sizeof(BELHeader);
+    if ((header.num_edges < 0) || (static_cast<size_t>(end - records) <
+                                   header.num_edges * record_bytes)) {
+      std::cout << "Truncated binary edge list " << filename_ << std::endl;
+      std::exit(-7);
+    }
+    EdgeList el(header.num_edges);
+    bool weighted_graph = !std::is_same<NodeID_, DestID_>::value;
+    bool same_layout = (header.id_bytes == sizeof(NodeID_)) &&
+                       (read_weights == weighted_graph) &&
+                       (record_bytes == sizeof(Edge));
+    const int64_t max_id = std::numeric_limits<NodeID_>::max();
+    bool negative = false, too_wide = false;
+    if (same_layout) {
+      ParallelCopy(el.data(), records, header.num_edges * sizeof(Edge));
+      #pragma omp parallel for reduction(|| : negative, too_wide)
+      for (int64_t e = 0; e < header.num_edges; e++) {
+        int64_t u = el[e].u;
+        int64_t v = static_cast<NodeID_>(el[e].v);
+        negative = negative || (u < 0) || (v < 0);
+        too_wide = too_wide || (u >= max_id) || (v >= max_id);
+      }
+    } else {
+      #pragma omp parallel for reduction(|| : negative, too_wide)
+      for (int64_t e = 0; e < header.num_edges; e++) {
+        const char *record = records + e * record_bytes;
+        int64_t u = ReadBELID(record, header.id_bytes);
+        int64_t v = ReadBELID(record + header.id_bytes, header.id_bytes);
+        negative = negative || (u < 0) || (v < 0);
+        too_wide = too_wide || (u >= max_id) || (v >= max_id);
+        NodeWeight<NodeID_, WeightT_> nw(v);
+        if (read_weights)
+          std::memcpy(&nw.w, record + 2*header.id_bytes, sizeof(WeightT_));
+        el[e] = MakeEdge(u, nw, read_weights);
       }
     }
+    if (negative) {
+      std::cout << "Binary edge list has negative IDs" << std::endl;
+      std::exit(-9);
+    }
+    ids_too_wide_ = too_wide;
     needs_weights = !read_weights;
     return el;
   }
@@ -224,37 +516,46 @@ class Reader {
     t.Start();
     EdgeList el;
     std::string suffix = GetSuffix();
-    std::ifstream file(filename_);
-    if (!file.is_open()) {
-      std::cout << "Couldn't open file " << filename_ << std::endl;
-      std::exit(-2);
-    }
-    if (suffix == ".el") {
-      el = ReadInEL(file);
-    } else if (suffix == ".wel") {
-      needs_weights = false;
-      el = ReadInWEL(file);
-    } else if (suffix == ".gr") {
-      needs_weights = false;
-      el = ReadInGR(file);
-    } else if (suffix == ".graph") {
-      el = ReadInMetis(file, needs_weights);
-    } else if (suffix == ".mtx") {
-      el = ReadInMTX(file, needs_weights);
+    if (CompressedFile::IsCompressedSuffix(suffix)) {
+      TextHeader header;
+      el = ReadInCompressed(suffix, header);
+      if (header.read_weights)
+        needs_weights = false;
     } else {
-      std::cout << "Unrecognized suffix: " << suffix << std::endl;
-      std::exit(-3);
+      MappedFile file(filename_);
+      file.Advise(MADV_WILLNEED);
+      const char *begin = file.data();
+      const char *end = begin + file.size();
+      if (IsTextFormat(suffix)) {
+        TextHeader header;
+        const char *body = ReadTextHeader(suffix, begin, end, header);
+        ReadTextBody(suffix, body, end, header, el);
+        if (header.read_weights)
+          needs_weights = false;
+      } else if ((suffix == ".bel") || (suffix == ".bwel")) {
+        el = ReadInBEL(begin, end, needs_weights);
+      } else {
+        std::cout << "Unrecognized suffix: " << suffix << std::endl;
+        std::exit(-3);
+      }
+    }
+    if (weights_out_of_range_) {
+      std::cout << "Weights in " << filename_ << " don't fit in "
+                << SGWeightName(SGWeightKindOf<WeightT_>(), sizeof(WeightT_))
+                << " (build with a wider WEIGHT, see Makefile)" << std::endl;
+      std::exit(-29);
     }
-    file.close();
     t.Stop();
     PrintTime("Read Time", t.Seconds());
     return el;
   }
 
-  CSRGraph<NodeID_, DestID_, invert> ReadSerializedGraph() {
+  void CheckSerializedTypes() {
     bool weighted = GetSuffix() == ".wsg";
-    if (!std::is_same<NodeID_, SGID>::value) {
-      std::cout << "serialized graphs only allowed for 32bit" << std::endl;
+    if ((sizeof(NodeID_) != sizeof(int32_t)) &&
+        (sizeof(NodeID_) != sizeof(int64_t))) {
+      std::cout << "serialized graphs only allowed for 32 or 64-bit IDs"
+                << std::endl;
       std::exit(-5);
     }
     if (!weighted && !std::is_same<NodeID_, DestID_>::value) {
@@ -265,45 +566,474 @@ class Reader {
       std::cout << ".wsg only allowed for weighted graphs" << std::endl;
       std::exit(-5);
     }
-    if (weighted && !std::is_same<WeightT_, SGID>::value) {
-      std::cout << ".wsg only allowed for int32_t weights" << std::endl;
-      std::exit(-5);
+  }
+
+  // Where each part of a serialized graph is within its file, so loading
+  // is the same regardless of the format version
+  struct SGLayout {
+    bool directed;
+    bool checksums;
+    bool compressed;  // if so, neighs sections are encoded bytes
+    bool has_inverse;  // directed graphs written without one don't
+    bool split_weights;  // if so, neighs sections are only IDs
+    SGOffset num_nodes;
+    SGOffset num_edges;
+    SGSection out_offsets, out_neighs, in_offsets, in_neighs;
+    SGSection out_byte_offsets, in_byte_offsets;
+    SGSection out_weights, in_weights;
+  };
+
+  // Used as expected_bytes of sections whose size isn't known in advance
+  static const uint64_t kAnySectionBytes = UINT64_MAX;
+
+  static SGSection MakeSection(uint32_t type, uint32_t elem_bytes,
+                               uint64_t offset, uint64_t bytes) {
+    SGSection section = SGSection();
+    section.type = type;
+    section.elem_bytes = elem_bytes;
+    section.offset = offset;
+    section.bytes = bytes;
+    return section;
+  }
+
+  void CheckSection(const SGSection *section, uint64_t expected_bytes,
+                    size_t file_size) {
+    if (section == nullptr) {
+      std::cout << "Missing section in serialized graph " << filename_
+                << std::endl;
+      std::exit(-9);
     }
-    std::ifstream file(filename_);
+    if ((expected_bytes != kAnySectionBytes) &&
+        (section->bytes != expected_bytes)) {
+      std::cout << "Section " << section->type << " of " << filename_
+                << " has unexpected size" << std::endl;
+      std::exit(-9);
+    }
+    if (section->offset + section->bytes > file_size) {
+      std::cout << "Truncated serialized graph " << filename_ << std::endl;
+      std::exit(-7);
+    }
+  }
+
+  // head is the start of the file (at least sizeof(SGHeader) if available)
+  SGLayout ParseSGLayout(const char *head, size_t head_bytes,
+                         size_t file_size) {
+    SGLayout layout;
+    if (SGHasMagic(head, head_bytes)) {
+      if (head_bytes < sizeof(SGHeader)) {
+        std::cout << "Truncated serialized graph " << filename_ << std::endl;
+        std::exit(-7);
+      }
+      SGHeader header;
+      std::memcpy(&header, head, sizeof(SGHeader));
+      if (header.version != kSGVersion) {
+        std::cout << "Unsupported serialized graph version: "
+                  << header.version << std::endl;
+        std::exit(-9);
+      }
+      if (header.id_bytes != sizeof(NodeID_)) {
+        std::cout << "Serialized graph has " << header.id_bytes
+                  << "-byte IDs but expected " << sizeof(NodeID_)
+                  << std::endl;
+        std::exit(-9);
+      }
+      bool weighted = header.flags & kSGWeighted;
+      if (weighted != !std::is_same<NodeID_, DestID_>::value) {
+        std::cout << "Serialized graph weights don't match expected"
+                  << std::endl;
+        std::exit(-9);
+      }
+      if (weighted && ((header.weight_bytes != sizeof(WeightT_)) ||
+                       (header.weight_kind != SGWeightKindOf<WeightT_>()))) {
+        std::cout << "Serialized graph has "
+                  << SGWeightName(header.weight_kind, header.weight_bytes)
+                  << " weights but expected "
+                  << SGWeightName(SGWeightKindOf<WeightT_>(),
+                                  sizeof(WeightT_))
+                  << std::endl;
+        std::exit(-9);
+      }
+      layout.directed = header.flags & kSGDirected;
+      layout.checksums = header.flags & kSGChecksums;
+      layout.compressed = header.flags & kSGCompressed;
+      layout.num_nodes = header.num_nodes;
+      layout.num_edges = header.num_edges;
+      if (layout.compressed && weighted) {
+        std::cout << "Compressed serialized graphs must be unweighted"
+                  << std::endl;
+        std::exit(-9);
+      }
+      // weights written before they were split are interleaved
+      layout.split_weights = weighted &&
+                             (header.FindSection(kSGOutWeights) != nullptr);
+      const uint64_t index_bytes = (layout.num_nodes+1) * sizeof(SGOffset);
+      const uint64_t neigh_bytes = layout.compressed ? kAnySectionBytes :
+          layout.num_edges * (layout.split_weights ? sizeof(NodeID_) :
+                                                     sizeof(DestID_));
+      const uint64_t weight_bytes = layout.num_edges * header.weight_bytes;
+      const SGSection *found;
+      found = header.FindSection(kSGOutOffsets);
+      CheckSection(found, index_bytes, file_size);
+      layout.out_offsets = *found;
+      found = header.FindSection(layout.compressed ? kSGOutCompressed :
+                                                     kSGOutNeighs);
+      CheckSection(found, neigh_bytes, file_size);
+      layout.out_neighs = *found;
+      if (layout.compressed) {
+        found = header.FindSection(kSGOutByteOffsets);
+        CheckSection(found, index_bytes, file_size);
+        layout.out_byte_offsets = *found;
+      }
+      if (layout.split_weights) {
+        found = header.FindSection(kSGOutWeights);
+        CheckSection(found, weight_bytes, file_size);
+        layout.out_weights = *found;
+      }
+      // without inverse sections, graph makes its inverse if needed
+      layout.has_inverse = layout.directed &&
+                           (header.FindSection(kSGInOffsets) != nullptr);
+      if (layout.has_inverse && invert) {
+        found = header.FindSection(kSGInOffsets);
+        CheckSection(found, index_bytes, file_size);
+        layout.in_offsets = *found;
+        found = header.FindSection(layout.compressed ? kSGInCompressed :
+                                                       kSGInNeighs);
+        CheckSection(found, neigh_bytes, file_size);
+        layout.in_neighs = *found;
+        if (layout.compressed) {
+          found = header.FindSection(kSGInByteOffsets);
+          CheckSection(found, index_bytes, file_size);
+          layout.in_byte_offsets = *found;
+        }
+        if (layout.split_weights) {
+          found = header.FindSection(kSGInWeights);
+          CheckSection(found, weight_bytes, file_size);
+          layout.in_weights = *found;
+        }
+      }
+    } else {
+      const size_t header_bytes = sizeof(bool) + 2*sizeof(SGOffset);
+      if (sizeof(NodeID_) != sizeof(SGID)) {
+        std::cout << "Version 1 serialized graphs only have " << sizeof(SGID)
+                  << "-byte IDs" << std::endl;
+        std::exit(-9);
+      }
+      if (!std::is_same<NodeID_, DestID_>::value &&
+          !std::is_same<WeightT_, SGID>::value) {
+        std::cout << "Version 1 serialized graphs only have int32 weights"
+                  << std::endl;
+        std::exit(-9);
+      }
+      if (head_bytes < header_bytes) {
+        std::cout << "Truncated serialized graph " << filename_ << std::endl;
+        std::exit(-7);
+      }
+      std::memcpy(&layout.directed, head, sizeof(bool));
+      std::memcpy(&layout.num_edges, head + sizeof(bool), sizeof(SGOffset));
+      std::memcpy(&layout.num_nodes, head + sizeof(bool) + sizeof(SGOffset),
+                  sizeof(SGOffset));
+      layout.checksums = false;
+      layout.compressed = false;
+      layout.has_inverse = layout.directed;
+      layout.split_weights = false;
+      uint64_t index_bytes = (layout.num_nodes+1) * sizeof(SGOffset);
+      uint64_t neigh_bytes = layout.num_edges * sizeof(DestID_);
+      uint64_t pos = header_bytes;
+      layout.out_offsets = MakeSection(kSGOutOffsets, sizeof(SGOffset), pos,
+                                       index_bytes);
+      pos += index_bytes;
+      layout.out_neighs = MakeSection(kSGOutNeighs, sizeof(DestID_), pos,
+                                      neigh_bytes);
+      pos += neigh_bytes;
+      layout.in_offsets = MakeSection(kSGInOffsets, sizeof(SGOffset), pos,
+                                      index_bytes);
+      pos += index_bytes;
+      layout.in_neighs = MakeSection(kSGInNeighs, sizeof(DestID_), pos,
+                                     neigh_bytes);
+      CheckSection(&layout.out_offsets, index_bytes, file_size);
+      CheckSection(&layout.out_neighs, neigh_bytes, file_size);
+      if (layout.directed && invert) {
+        CheckSection(&layout.in_offsets, index_bytes, file_size);
+        CheckSection(&layout.in_neighs, neigh_bytes, file_size);
+      }
+    }
+    return layout;
+  }
+
+  void ReadSection(std::ifstream &file, const SGSection &section, void *dest,
+                   bool verify) {
+    file.seekg(section.offset);
+    file.read(reinterpret_cast<char*>(dest), section.bytes);
+    if (verify && (SGChecksum(dest, section.bytes) != section.checksum)) {
+      std::cout << "Checksum mismatch in section " << section.type << " of "
+                << filename_ << std::endl;
+      std::exit(-10);
+    }
+  }
+
+  // Interleaves neighbors stored apart from their weights into neighs
+  static void JoinWeights(const NodeID_ *ids, const WeightT_ *weights,
+                          int64_t num_edges, DestID_ *neighs) {
+    if constexpr (!std::is_same<NodeID_, DestID_>::value) {
+      #pragma omp parallel for
+      for (int64_t e = 0; e < num_edges; e++)
+        neighs[e] = DestID_(ids[e], weights[e]);
+    }
+  }
+
+  // Reads a direction's neighbors (to their offsets) into neighs, decoding
+  // them if they were compressed, or joining them with their weights if
+  // stored apart
+  void ReadNeighsSection(std::ifstream &file, const SGLayout &layout,
+                         const SGSection &neighs_section,
+                         const SGSection &byte_offsets_section,
+                         const SGSection &weights_section,
+                         const pvector<SGOffset> &offsets, DestID_ *neighs) {
+    if (layout.split_weights) {
+      pvector<NodeID_> ids(layout.num_edges);
+      pvector<WeightT_> weights(layout.num_edges);
+      ReadSection(file, neighs_section, ids.data(), layout.checksums);
+      ReadSection(file, weights_section, weights.data(), layout.checksums);
+      JoinWeights(ids.data(), weights.data(), layout.num_edges, neighs);
+      return;
+    }
+    if (!layout.compressed) {
+      ReadSection(file, neighs_section, neighs, layout.checksums);
+      return;
+    }
+    pvector<SGOffset> byte_offsets(layout.num_nodes+1);
+    pvector<uint8_t> bytes(neighs_section.bytes);
+    ReadSection(file, byte_offsets_section, byte_offsets.data(),
+                layout.checksums);
+    ReadSection(file, neighs_section, bytes.data(), layout.checksums);
+    // only unweighted graphs are compressed, so DestID_ is NodeID_
+    bool consistent =
+        (byte_offsets[layout.num_nodes] == SGOffset(bytes.size())) &&
+        CompressedCSRGraph<NodeID_>::DecodeNeighborhoods(layout.num_nodes,
+            byte_offsets.data(), bytes.data(), offsets.data(),
+            reinterpret_cast<NodeID_*>(neighs));
+    if (!consistent) {
+      std::cout << "Corrupt compressed neighbors in " << filename_
+                << std::endl;
+      std::exit(-9);
+    }
+  }
+
+  // Reads inverse sections of file (only once the graph needs them)
+  Index ReadInverse(const SGLayout &layout, DestID_ **inv_neighs) {
+    std::ifstream file(filename_, std::ios::binary);
+    if (!file.is_open()) {
+      std::cout << "Couldn't open file " << filename_ << std::endl;
+      std::exit(-6);
+    }
+    pvector<SGOffset> offsets(layout.num_nodes+1);
+    ReadSection(file, layout.in_offsets, offsets.data(), layout.checksums);
+    *inv_neighs = new DestID_[layout.num_edges];
+    NUMAPlaceNeighs(*inv_neighs, offsets.data(), layout.num_nodes);
+    AdviseArray(*inv_neighs, layout.num_edges);
+    ReadNeighsSection(file, layout, layout.in_neighs, layout.in_byte_offsets,
+                      layout.in_weights, offsets, *inv_neighs);
+    return Index(offsets.data(), layout.num_nodes, *inv_neighs);
+  }
+
+  // Inverse of a directed graph is read from the file when first needed
+  CSRGraphT ReadSerializedGraph() {
+    CheckSerializedTypes();
+    std::ifstream file(filename_, std::ios::binary);
     if (!file.is_open()) {
       std::cout << "Couldn't open file " << filename_ << std::endl;
       std::exit(-6);
     }
     Timer t;
     t.Start();
-    bool directed;
-    SGOffset num_nodes, num_edges;
-    DestID_ **index = nullptr, **inv_index = nullptr;
-    DestID_ *neighs = nullptr, *inv_neighs = nullptr;
-    file.read(reinterpret_cast<char*>(&directed), sizeof(bool));
-    file.read(reinterpret_cast<char*>(&num_edges), sizeof(SGOffset));
-    file.read(reinterpret_cast<char*>(&num_nodes), sizeof(SGOffset));
-    pvector<SGOffset> offsets(num_nodes+1);
-    neighs = new DestID_[num_edges];
-    std::streamsize num_index_bytes = (num_nodes+1) * sizeof(SGOffset);
-    std::streamsize num_neigh_bytes = num_edges * sizeof(DestID_);
-    file.read(reinterpret_cast<char*>(offsets.data()), num_index_bytes);
-    file.read(reinterpret_cast<char*>(neighs), num_neigh_bytes);
-    index = CSRGraph<NodeID_, DestID_>::GenIndex(offsets, neighs);
-    if (directed && invert) {
-      inv_neighs = new DestID_[num_edges];
-      file.read(reinterpret_cast<char*>(offsets.data()), num_index_bytes);
-      file.read(reinterpret_cast<char*>(inv_neighs), num_neigh_bytes);
-      inv_index = CSRGraph<NodeID_, DestID_>::GenIndex(offsets, inv_neighs);
-    }
+    file.seekg(0, std::ios::end);
+    size_t file_size = file.tellg();
+    file.seekg(0);
+    SGHeader head;
+    file.read(reinterpret_cast<char*>(&head), sizeof(SGHeader));
+    size_t head_bytes = file.gcount();
+    file.clear();
+    SGLayout layout = ParseSGLayout(reinterpret_cast<char*>(&head),
+                                    head_bytes, file_size);
+    Index index;
+    DestID_ *neighs = nullptr;
+    pvector<SGOffset> offsets(layout.num_nodes+1);
+    ReadSection(file, layout.out_offsets, offsets.data(), layout.checksums);
+    neighs = new DestID_[layout.num_edges];
+    NUMAPlaceNeighs(neighs, offsets.data(), layout.num_nodes);
+    AdviseArray(neighs, layout.num_edges);
+    ReadNeighsSection(file, layout, layout.out_neighs,
+                      layout.out_byte_offsets, layout.out_weights, offsets,
+                      neighs);
+    index = Index(offsets.data(), layout.num_nodes, neighs);
     file.close();
     t.Stop();
     PrintTime("Read Time", t.Seconds());
-    if (directed)
-      return CSRGraph<NodeID_, DestID_, invert>(num_nodes, index, neighs,
-                                                inv_index, inv_neighs);
+    typename CSRGraphT::InverseLoader inverse_loader;
+    if (layout.has_inverse && invert) {
+      inverse_loader = [reader = *this, layout](DestID_ **inv_neighs) mutable {
+        return reader.ReadInverse(layout, inv_neighs);
+      };
+    }
+    if (layout.directed)
+      return CSRGraphT(layout.num_nodes, index, neighs, Index(), nullptr,
+                       nullptr, inverse_loader);
+    else
+      return CSRGraphT(layout.num_nodes, index, neighs);
+  }
+
+  template <typename T>
+  static bool IsAligned(const MappedFile &file, const SGSection &section) {
+    uintptr_t start = reinterpret_cast<uintptr_t>(file.data());
+    return (start + section.offset) % alignof(T) == 0;
+  }
+
+  // Returns pointer to section of mapped file to be used in place, or if
+  // it must be copied (e.g. not aligned for its type) a new copy of it
+  template <typename T>
+  static T* MapOrCopy(const MappedFile &file, const SGSection &section,
+                      bool copy) {
+    const char *start = file.data() + section.offset;
+    if (!copy)
+      return reinterpret_cast<T*>(const_cast<char*>(start));
+    T *dest = new T[section.bytes / sizeof(T)];
+    NUMAPlace(dest, section.bytes);
+    ParallelCopy(dest, start, section.bytes);
+    return dest;
+  }
+
+  // MapOrCopy for a direction's neighbors, except neighbors stored apart
+  // from their weights are always copied (joined with their weights)
+  static DestID_* MapOrJoin(const MappedFile &file, const SGLayout &layout,
+                            const SGSection &neighs_section,
+                            const SGSection &weights_section, bool copy) {
+    if (!layout.split_weights)
+      return MapOrCopy<DestID_>(file, neighs_section, copy);
+    DestID_ *neighs = new DestID_[layout.num_edges];
+    NUMAPlace(neighs, layout.num_edges * sizeof(DestID_));
+    JoinWeights(
+        reinterpret_cast<const NodeID_*>(file.data() + neighs_section.offset),
+        reinterpret_cast<const WeightT_*>(file.data() + weights_section.offset),
+        layout.num_edges, neighs);
+    return neighs;
+  }
+
+  // Same result as ReadSerializedGraph, but neighbors are used directly out
+  // of a memory-mapping of the file, so nothing is read up front and the
+  // pages are shared through the OS page cache. Only the index is built
+  // (the inverse's only when first needed), an OffsetIndex uses the file's
+  // offsets in place, so it isn't built either. Sections not aligned for
+  // their types (only possible in version 1 files) are copied out of the
+  // mapping instead, as are weighted neighbors, which are joined with their
+  // weights (SplitCSRGraph uses them in place, see LoadSplitGraph). To keep
+  // startup instant, checksums are not verified. Compressed files are read
+  // (and decoded).
+  CSRGraphT MapSerializedGraph() {
+    CheckSerializedTypes();
+    Timer t;
+    t.Start();
+    std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>(filename_);
+    SGLayout layout = ParseSGLayout(file->data(), file->size(), file->size());
+    if (layout.compressed)  // has to be decoded, so can't be used in place
+      return ReadSerializedGraph();
+    bool load_inverse = layout.has_inverse && invert;
+    bool copy_offsets = !IsAligned<SGOffset>(*file, layout.out_offsets) ||
+        (load_inverse && !IsAligned<SGOffset>(*file, layout.in_offsets));
+    bool copy_neighs = layout.split_weights ||
+        !IsAligned<DestID_>(*file, layout.out_neighs) ||
+        (load_inverse && !IsAligned<DestID_>(*file, layout.in_neighs));
+    // offsets can only be used in place if the mapping is kept
+    bool offsets_in_place = !copy_offsets && !copy_neighs;
+    DestID_ *neighs = nullptr;
+    SGOffset *offsets = MapOrCopy<SGOffset>(*file, layout.out_offsets,
+                                            copy_offsets);
+    neighs = MapOrJoin(*file, layout, layout.out_neighs, layout.out_weights,
+                       copy_neighs);
+    Index index(offsets, layout.num_nodes, neighs, offsets_in_place);
+    if (copy_offsets)
+      delete[] offsets;
+    typename CSRGraphT::InverseLoader inverse_loader;
+    if (load_inverse) {
+      inverse_loader = [file, layout, copy_offsets, copy_neighs,
+                        offsets_in_place](DestID_ **inv_neighs) {
+        SGOffset *offsets = MapOrCopy<SGOffset>(*file, layout.in_offsets,
+                                                copy_offsets);
+        *inv_neighs = MapOrJoin(*file, layout, layout.in_neighs,
+                                layout.in_weights, copy_neighs);
+        Index inv_index(offsets, layout.num_nodes, *inv_neighs,
+                        offsets_in_place);
+        if (copy_offsets)
+          delete[] offsets;
+        return inv_index;
+      };
+    }
+    // If neighbors were copied, the graph owns them and mapping can go away
+    std::shared_ptr<void> neigh_storage;
+    if (!copy_neighs)
+      neigh_storage = file;
+    t.Stop();
+    PrintLabel("Graph Load", copy_neighs ? "copied" : "mmap");
+    PrintTime("Read Time", t.Seconds());
+    if (layout.directed)
+      return CSRGraphT(layout.num_nodes, index, neighs, Index(), nullptr,
+                       neigh_storage, inverse_loader);
+    else
+      return CSRGraphT(layout.num_nodes, index, neighs, neigh_storage);
+  }
+
+  // Loads weighted graph with its weights apart from its neighbors, which
+  // is how they are stored, so sections are copied (or used in place from
+  // the mapping if map) without conversion. Files with interleaved weights
+  // (from before they were split), or directed graphs whose inverse is
+  // needed but wasn't stored, are loaded as a CSRGraph and then split.
+  SplitCSRGraph<NodeID_, WeightT_, invert> LoadSplitGraph(bool map) {
+    typedef SplitCSRGraph<NodeID_, WeightT_, invert> SGraph;
+    CheckSerializedTypes();
+    Timer t;
+    t.Start();
+    std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>(filename_);
+    SGLayout layout = ParseSGLayout(file->data(), file->size(), file->size());
+    bool load_inverse = layout.directed && invert;
+    if (!layout.split_weights || (load_inverse && !layout.has_inverse)) {
+      file.reset();
+      return SGraph::FromCSR(map ? MapSerializedGraph() :
+                                   ReadSerializedGraph());
+    }
+    bool verify = layout.checksums && !map;
+    auto load = [this, &file, map, verify](const SGSection &section,
+                                           auto *type) {
+      typedef typename std::remove_pointer<decltype(type)>::type T;
+      T *data = MapOrCopy<T>(*file, section, !map);
+      if (verify && (SGChecksum(data, section.bytes) != section.checksum)) {
+        std::cout << "Checksum mismatch in section " << section.type
+                  << " of " << filename_ << std::endl;
+        std::exit(-10);
+      }
+      return data;
+    };
+    SGOffset *out_offsets = load(layout.out_offsets, (SGOffset*) nullptr);
+    NodeID_ *out_ids = load(layout.out_neighs, (NodeID_*) nullptr);
+    WeightT_ *out_weights = load(layout.out_weights, (WeightT_*) nullptr);
+    SGOffset *in_offsets = nullptr;
+    NodeID_ *in_ids = nullptr;
+    WeightT_ *in_weights = nullptr;
+    if (load_inverse) {
+      in_offsets = load(layout.in_offsets, (SGOffset*) nullptr);
+      in_ids = load(layout.in_neighs, (NodeID_*) nullptr);
+      in_weights = load(layout.in_weights, (WeightT_*) nullptr);
+    }
+    std::shared_ptr<void> storage;
+    if (map)
+      storage = file;
+    t.Stop();
+    PrintLabel("Graph Load", map ? "mmap" : "copied");
+    PrintTime("Read Time", t.Seconds());
+    if (layout.directed)
+      return SGraph(layout.num_nodes, out_offsets, out_ids, out_weights,
+                    in_offsets, in_ids, in_weights, storage);
     else
-      return CSRGraph<NodeID_, DestID_, invert>(num_nodes, index, neighs);
+      return SGraph(layout.num_nodes, out_offsets, out_ids, out_weights,
+                    storage);
   }
 };
 
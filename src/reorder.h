@@ -0,0 +1,363 @@
+// Copyright (c) 2015, The Regents of the University of California (Regents)
+// See LICENSE.txt for license details
+
+#ifndef REORDER_H_
+#define REORDER_H_
+
+#include <algorithm>
+#include <cinttypes>
+#include <fstream>
+#include <limits>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "platform_atomics.h"
+#include "pvector.h"
+#include "radix_sort.h"
+#include "sliding_queue.h"
+
+
+/*
+GAP Benchmark Suite
+File:   Reorder
+
+Vertex orderings that improve locality, the builder relabels the graph with
+one if given (-R on command line, see CLBase) before any kernel runs
+ - Each returns new_ids, where new_ids[v] is vertex v's new ID
+ - degree: decreasing degree (ties by ID)
+ - hub-sort: hubs (degree above average) first by decreasing degree, then
+   the rest in their original order (frequency-based clustering)
+ - hub-cluster: hubs first, then the rest, both in their original order
+ - dbg: degree-based grouping, groups of vertices with degrees within a
+   power of two of each other (relative to average), hottest group first,
+   original order within groups
+ - rcm: reverse Cuthill-McKee, BFS from low-degree vertices that places
+   each level by order of parents, then degree, then reversed
+ - gorder: Gorder-lite, greedily places next the vertex sharing the most
+   neighbors with the last kGorderWindow placed ones, within independent
+   blocks of vertices (in parallel), neighbors of high-degree vertices
+   aren't used to find siblings
+ - Orders only depend on the graph (not the number of threads)
+ - Degrees come from the caller (so out-, in-, or total degree can order a
+   directed graph), rcm and gorder traverse out-neighbors
+*/
+
+
+enum class ReorderStrategy {
+  kNone, kDegree, kHubSort, kHubCluster, kDBG, kRCM, kGorder
+};
+
+// Which degree orders vertices (only differ for directed graphs)
+enum class DegreeKind { kOut, kIn, kTotal };
+
+// Returns false if spec isn't strategy[:out|in|total] with a recognized
+// strategy (degree kind is out if not given)
+inline bool ParseReorderStrategy(const std::string &spec,
+                                 ReorderStrategy *strategy,
+                                 DegreeKind *degree_kind) {
+  const size_t colon = spec.find(':');
+  const std::string name = spec.substr(0, colon);
+  *degree_kind = DegreeKind::kOut;
+  if (colon != std::string::npos) {
+    const std::string kind = spec.substr(colon + 1);
+    if (kind == "in")
+      *degree_kind = DegreeKind::kIn;
+    else if (kind == "total")
+      *degree_kind = DegreeKind::kTotal;
+    else if (kind != "out")
+      return false;
+  }
+  if (name == "none")
+    *strategy = ReorderStrategy::kNone;
+  else if (name == "degree")
+    *strategy = ReorderStrategy::kDegree;
+  else if (name == "hub-sort")
+    *strategy = ReorderStrategy::kHubSort;
+  else if (name == "hub-cluster")
+    *strategy = ReorderStrategy::kHubCluster;
+  else if (name == "dbg")
+    *strategy = ReorderStrategy::kDBG;
+  else if (name == "rcm")
+    *strategy = ReorderStrategy::kRCM;
+  else if (name == "gorder")
+    *strategy = ReorderStrategy::kGorder;
+  else
+    return false;
+  return true;
+}
+
+namespace reorder_internal {
+
+static const int kDBGGroups = 8;
+static const int kGorderWindow = 5;
+static const int64_t kGorderBlockSize = 1 << 16;
+static const int64_t kGorderMaxSiblingDegree = 32;
+static const int64_t kRCMSmallLevel = 1024;
+
+template <typename GraphT_, typename DegreeFunc>
+double AverageDegree(const GraphT_ &g, DegreeFunc degree) {
+  int64_t total = 0;
+  #pragma omp parallel for reduction(+ : total)
+  for (int64_t n = 0; n < g.num_nodes(); n++)
+    total += degree(n);
+  return g.num_nodes() == 0 ? 0 : static_cast<double>(total) / g.num_nodes();
+}
+
+// Vertices stably sorted by key (so ties keep their original order),
+// returned as new IDs
+template <typename NodeID_, typename GraphT_, typename KeyFunc>
+pvector<NodeID_> OrderByKey(const GraphT_ &g, KeyFunc key) {
+  pvector<NodeID_> order(g.num_nodes());
+  #pragma omp parallel for
+  for (NodeID_ n = 0; n < g.num_nodes(); n++)
+    order[n] = n;
+  {
+    pvector<NodeID_> temp(g.num_nodes());
+    ParallelRadixSort(order.data(), temp.data(), g.num_nodes(), key);
+  }
+  pvector<NodeID_> new_ids(g.num_nodes());
+  #pragma omp parallel for
+  for (NodeID_ i = 0; i < g.num_nodes(); i++)
+    new_ids[order[i]] = i;
+  return new_ids;
+}
+
+// Group of DBG (higher is hotter), boundaries are avg/2, avg, 2*avg, ...
+inline int DBGGroup(int64_t degree, double avg_degree) {
+  double bound = avg_degree / 2;
+  int group = 0;
+  while ((group < kDBGGroups - 1) && (degree >= bound)) {
+    group++;
+    bound *= 2;
+  }
+  return group;
+}
+
+template <typename NodeID_, typename GraphT_, typename DegreeFunc>
+pvector<NodeID_> RCMOrder(const GraphT_ &g, DegreeFunc degree) {
+  typedef unsigned __int128 KeyT;
+  const int64_t num_nodes = g.num_nodes();
+  const int kIDBits = 8 * sizeof(NodeID_);
+  const uint64_t kMaxDegreeKey = kIDBits >= 64 ? 0 :
+                                 (uint64_t(1) << (64 - kIDBits)) - 1;
+  const int64_t kUnreached = std::numeric_limits<int64_t>::max();
+  // position in order of first vertex (of previous level) that reached it
+  pvector<int64_t> parent_pos(num_nodes, kUnreached);
+  auto key = [&](NodeID_ v) {
+    uint64_t degree_key = std::min<uint64_t>(degree(v), kMaxDegreeKey);
+    uint64_t low = kIDBits >= 64 ? OrderedBits(v) :
+                   (degree_key << kIDBits) | OrderedBits(v);
+    return (KeyT(parent_pos[v]) << 64) | low;
+  };
+  // components are started from lowest-degree vertices not reached yet
+  pvector<NodeID_> seed_pos = OrderByKey<NodeID_>(g, [&degree](NodeID_ v) {
+    return static_cast<uint64_t>(degree(v));
+  });
+  pvector<NodeID_> seed_order(num_nodes);
+  #pragma omp parallel for
+  for (NodeID_ v = 0; v < num_nodes; v++)
+    seed_order[seed_pos[v]] = v;
+  SlidingQueue<NodeID_> queue(num_nodes);
+  // queue's buffer ends up holding every vertex in Cuthill-McKee order
+  NodeID_ *cm_order = queue.begin();
+  pvector<NodeID_> temp(num_nodes);
+  int64_t next_seed = 0;
+  int64_t num_placed = 0;
+  while (num_placed < num_nodes) {
+    while (parent_pos[seed_order[next_seed]] != kUnreached)
+      next_seed++;
+    NodeID_ seed = seed_order[next_seed];
+    parent_pos[seed] = -1;
+    queue.push_back(seed);
+    queue.slide_window();
+    while (!queue.empty()) {
+      const int64_t level_start = num_placed;
+      num_placed += queue.size();
+      #pragma omp parallel if (queue.size() > kRCMSmallLevel)
+      {
+        QueueBuffer<NodeID_> lqueue(queue);
+        #pragma omp for nowait
+        for (auto q_iter = queue.begin(); q_iter < queue.end(); q_iter++) {
+          const int64_t pos = level_start + (q_iter - queue.begin());
+          for (NodeID_ v : g.out_neigh(*q_iter)) {
+            int64_t curr = parent_pos[v];
+            while ((curr > pos) &&
+                   !compare_and_swap(parent_pos[v], curr, pos))
+              curr = parent_pos[v];
+            if (curr == kUnreached)
+              lqueue.push_back(v);
+          }
+        }
+        lqueue.flush();
+      }
+      queue.slide_window();
+      NodeID_ *level = queue.begin();
+      if (queue.size() > kRCMSmallLevel) {
+        ParallelRadixSort(level, temp.data(), queue.size(), key);
+      } else {
+        std::sort(level, queue.end(), [&key](NodeID_ a, NodeID_ b) {
+          return key(a) < key(b);
+        });
+      }
+    }
+  }
+  pvector<NodeID_> new_ids(num_nodes);
+  #pragma omp parallel for
+  for (int64_t i = 0; i < num_nodes; i++)
+    new_ids[cm_order[i]] = num_nodes - 1 - i;
+  return new_ids;
+}
+
+// Places vertices [start, end) greedily, new IDs stay within [start, end),
+// candidates are kept in buckets by score (entries are checked when taken,
+// so stale ones are just skipped)
+template <typename NodeID_, typename GraphT_, typename DegreeFunc>
+void GorderBlock(const GraphT_ &g, DegreeFunc degree, NodeID_ start,
+                 NodeID_ end, pvector<NodeID_> &new_ids) {
+  const int64_t size = end - start;
+  std::vector<int32_t> score(size, 0);
+  std::vector<bool> placed(size, false);
+  std::vector<std::vector<NodeID_>> buckets(1);
+  int32_t max_score = 0;
+  std::vector<NodeID_> by_degree(size);
+  for (int64_t i = 0; i < size; i++)
+    by_degree[i] = start + i;
+  std::stable_sort(by_degree.begin(), by_degree.end(),
+                   [&degree](NodeID_ a, NodeID_ b) {
+                     return degree(a) > degree(b);
+                   });
+  auto unplaced = [&](NodeID_ v) {
+    return (v >= start) && (v < end) && !placed[v - start];
+  };
+  auto add = [&](NodeID_ v, int32_t delta) {
+    int32_t &s = score[v - start];
+    s += delta;
+    if (s <= 0)
+      return;
+    if (s >= static_cast<int32_t>(buckets.size()))
+      buckets.resize(s + 1);
+    buckets[s].push_back(v);
+    max_score = std::max(max_score, s);
+  };
+  // neighbors and siblings (other neighbors of neighbors) of v gain delta
+  auto update = [&](NodeID_ v, int32_t delta) {
+    for (NodeID_ u : g.out_neigh(v)) {
+      if (unplaced(u))
+        add(u, delta);
+      if (g.out_degree(u) > kGorderMaxSiblingDegree)
+        continue;
+      for (NodeID_ x : g.out_neigh(u)) {
+        if ((x != v) && unplaced(x))
+          add(x, delta);
+      }
+    }
+  };
+  std::queue<NodeID_> window;
+  int64_t next_by_degree = 0;
+  for (int64_t i = 0; i < size; i++) {
+    NodeID_ next = -1;
+    while ((max_score > 0) && (next == -1)) {
+      std::vector<NodeID_> &bucket = buckets[max_score];
+      if (bucket.empty()) {
+        max_score--;
+        continue;
+      }
+      NodeID_ v = bucket.back();
+      bucket.pop_back();
+      if (!placed[v - start] && (score[v - start] == max_score))
+        next = v;
+    }
+    if (next == -1) {
+      while (placed[by_degree[next_by_degree] - start])
+        next_by_degree++;
+      next = by_degree[next_by_degree];
+    }
+    placed[next - start] = true;
+    new_ids[next] = start + i;
+    update(next, 1);
+    window.push(next);
+    if (static_cast<int>(window.size()) > kGorderWindow) {
+      update(window.front(), -1);
+      window.pop();
+    }
+  }
+}
+
+template <typename NodeID_, typename GraphT_, typename DegreeFunc>
+pvector<NodeID_> GorderOrder(const GraphT_ &g, DegreeFunc degree) {
+  pvector<NodeID_> new_ids(g.num_nodes());
+  const int64_t num_blocks = (g.num_nodes() + kGorderBlockSize - 1) /
+                             kGorderBlockSize;
+  #pragma omp parallel for schedule(dynamic, 1)
+  for (int64_t b = 0; b < num_blocks; b++) {
+    NodeID_ start = b * kGorderBlockSize;
+    NodeID_ end = std::min<int64_t>(g.num_nodes(), start + kGorderBlockSize);
+    GorderBlock(g, degree, start, end, new_ids);
+  }
+  return new_ids;
+}
+
+}  // namespace reorder_internal
+
+
+// Vertices are ordered by degree(v) (where degrees matter)
+template <typename NodeID_, typename GraphT_, typename DegreeFunc>
+pvector<NodeID_> ComputeOrder(const GraphT_ &g, ReorderStrategy strategy,
+                              DegreeFunc degree) {
+  using namespace reorder_internal;
+  switch (strategy) {
+    case ReorderStrategy::kDegree:
+      return OrderByKey<NodeID_>(g, [&degree](NodeID_ v) {
+        return ~static_cast<uint64_t>(degree(v));
+      });
+    case ReorderStrategy::kHubSort: {
+      const double avg_degree = AverageDegree(g, degree);
+      return OrderByKey<NodeID_>(g, [&degree, avg_degree](NodeID_ v) {
+        int64_t d = degree(v);
+        return d > avg_degree ? ~static_cast<uint64_t>(d) :
+                                std::numeric_limits<uint64_t>::max();
+      });
+    }
+    case ReorderStrategy::kHubCluster: {
+      const double avg_degree = AverageDegree(g, degree);
+      return OrderByKey<NodeID_>(g, [&degree, avg_degree](NodeID_ v) {
+        return static_cast<uint64_t>(degree(v) <= avg_degree);
+      });
+    }
+    case ReorderStrategy::kDBG: {
+      const double avg_degree = AverageDegree(g, degree);
+      return OrderByKey<NodeID_>(g, [&degree, avg_degree](NodeID_ v) {
+        return static_cast<uint64_t>(kDBGGroups - 1 -
+                                     DBGGroup(degree(v), avg_degree));
+      });
+    }
+    case ReorderStrategy::kRCM:
+      return RCMOrder<NodeID_>(g, degree);
+    case ReorderStrategy::kGorder:
+      return GorderOrder<NodeID_>(g, degree);
+    default: {
+      pvector<NodeID_> new_ids(g.num_nodes());
+      #pragma omp parallel for
+      for (NodeID_ n = 0; n < g.num_nodes(); n++)
+        new_ids[n] = n;
+      return new_ids;
+    }
+  }
+}
+
+// Text, line v is the new ID of (original) vertex v, returns false if the
+// file couldn't be written
+template <typename NodeID_>
+bool WritePermutation(const pvector<NodeID_> &new_ids,
+                      const std::string &filename) {
+  std::ofstream out(filename);
+  if (!out.is_open())
+    return false;
+  for (NodeID_ new_id : new_ids)
+    out << new_id << "\n";
+  return static_cast<bool>(out);
+}
+
+#endif  // REORDER_H_
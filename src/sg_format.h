@@ -0,0 +1,162 @@
+// Copyright (c) 2015, The Regents of the University of California (Regents)
+// See LICENSE.txt for license details
+
+#ifndef SG_FORMAT_H_
+#define SG_FORMAT_H_
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+#include "pvector.h"
+
+
+/*
+GAP Benchmark Suite
+File:   Serialized Graph Format
+
+On-disk layout of serialized graphs (.sg & .wsg) shared by Reader and Writer
+
+Version 1 (legacy, read-only):
+  bool directed, SGOffset num_edges, SGOffset num_nodes, then back-to-back
+  out offsets, out neighbors, and if directed in offsets, in neighbors
+
+Version 2:
+  SGHeader at start of file, followed by the sections it lists
+ - Every section starts on a kSGAlignment boundary so it can be used in
+   place from a memory-mapping of the file
+ - Sections are found by type through the header's section table, so new
+   section types can be added without breaking older readers
+ - IDs are id_bytes wide (4 or 8), and are loaded as stored, so only by
+   binaries with NodeIDs of that width (see id_width.h)
+ - Checksums per section are optional (kSGChecksums flag)
+ - Weights are weight_bytes wide and of weight_kind (e.g. 1-byte unsigned
+   for uint8_t, 4-byte float for float), and are loaded as stored, so only
+   by binaries built with that WeightT (see Makefile)
+ - Weights (.wsg) are in their own sections (kSGOutWeights & kSGInWeights),
+   parallel to the neighbors sections, which then hold only IDs. Files with
+   neighbors and weights interleaved (no weights sections) are still read
+ - If compressed (kSGCompressed flag, unweighted only), each direction's
+   neighbors section is replaced by byte offsets and neighborhoods encoded
+   as by CompressedCSRGraph (see compressed_graph.h)
+*/
+
+
+static const char kSGMagic[8] = {'G', 'A', 'P', 'B', 'S', 'S', 'G', '\0'};
+static const uint32_t kSGVersion = 2;
+static const size_t kSGAlignment = 4096;
+static const uint32_t kSGMaxSections = 16;
+
+// Header flags
+static const uint32_t kSGDirected = 1 << 0;
+static const uint32_t kSGWeighted = 1 << 1;
+static const uint32_t kSGChecksums = 1 << 2;
+static const uint32_t kSGCompressed = 1 << 3;
+
+enum SGSectionType : uint32_t {
+  kSGOutOffsets = 1,
+  kSGOutNeighs = 2,
+  kSGInOffsets = 3,
+  kSGInNeighs = 4,
+  kSGOutWeights = 5,
+  kSGInWeights = 6,
+  kSGOutByteOffsets = 7,
+  kSGOutCompressed = 8,
+  kSGInByteOffsets = 9,
+  kSGInCompressed = 10
+};
+
+// Kind of number weights are, with weight_bytes gives their type (files
+// from before weights could have other types have 0, for int32_t)
+enum SGWeightKind : uint32_t {
+  kSGSignedWeights = 0,
+  kSGUnsignedWeights = 1,
+  kSGFloatWeights = 2
+};
+
+struct SGSection {
+  uint32_t type;
+  uint32_t elem_bytes;
+  uint64_t offset;    // from start of file, multiple of kSGAlignment
+  uint64_t bytes;
+  uint64_t checksum;  // 0 unless header has kSGChecksums
+};
+
+struct SGHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t flags;
+  uint32_t id_bytes;
+  uint32_t weight_bytes;  // 0 if unweighted
+  int64_t num_nodes;
+  int64_t num_edges;      // neighbors stored per direction
+  uint32_t num_sections;
+  uint32_t weight_kind;   // SGWeightKind, 0 if unweighted
+  SGSection sections[kSGMaxSections];
+
+  const SGSection* FindSection(uint32_t type) const {
+    for (uint32_t i = 0; i < std::min(num_sections, kSGMaxSections); i++)
+      if (sections[i].type == type)
+        return &sections[i];
+    return nullptr;
+  }
+};
+
+inline uint64_t SGAlignUp(uint64_t pos) {
+  return (pos + kSGAlignment - 1) / kSGAlignment * kSGAlignment;
+}
+
+inline bool SGHasMagic(const char *head, size_t head_bytes) {
+  return (head_bytes >= sizeof(kSGMagic)) &&
+         (std::memcmp(head, kSGMagic, sizeof(kSGMagic)) == 0);
+}
+
+// FNV-1a style hash over 8-byte words, computed per block in parallel and
+// then combined in block order, so result doesn't depend on thread count
+inline uint64_t SGChecksum(const void *data, size_t num_bytes) {
+  const uint64_t kPrime = 1099511628211ull;
+  const uint64_t kBasis = 14695981039346656037ull;
+  const size_t block_size = 1 << 20;
+  const int64_t num_blocks = (num_bytes + block_size - 1) / block_size;
+  const char *bytes = static_cast<const char*>(data);
+  pvector<uint64_t> block_sums(num_blocks);
+  #pragma omp parallel for
+  for (int64_t block = 0; block < num_blocks; block++) {
+    size_t start = block * block_size;
+    size_t end = std::min(start + block_size, num_bytes);
+    uint64_t h = kBasis;
+    size_t i = start;
+    for (; i + sizeof(uint64_t) <= end; i += sizeof(uint64_t)) {
+      uint64_t word;
+      std::memcpy(&word, bytes + i, sizeof(uint64_t));
+      h = (h ^ word) * kPrime;
+    }
+    for (; i < end; i++)
+      h = (h ^ static_cast<unsigned char>(bytes[i])) * kPrime;
+    block_sums[block] = h;
+  }
+  uint64_t total = kBasis ^ num_bytes;
+  for (int64_t block = 0; block < num_blocks; block++)
+    total = (total ^ block_sums[block]) * kPrime;
+  return total;
+}
+
+template <typename WeightT_>
+inline uint32_t SGWeightKindOf() {
+  if (std::is_floating_point<WeightT_>::value)
+    return kSGFloatWeights;
+  return std::is_signed<WeightT_>::value ? kSGSignedWeights :
+                                           kSGUnsignedWeights;
+}
+
+// Name of weight type (e.g. uint8 or float), for messages
+inline std::string SGWeightName(uint32_t kind, uint32_t bytes) {
+  if (kind == kSGFloatWeights)
+    return bytes == sizeof(float) ? "float" : "double";
+  return (kind == kSGUnsignedWeights ? "uint" : "int") +
+         std::to_string(8 * bytes);
+}
+
+#endif  // SG_FORMAT_H_
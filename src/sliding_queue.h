@@ -7,10 +7,8 @@
 #include <algorithm>
 #include <bitset>
 #include <iostream>
-#include <numa.h>
-#include <numaif.h>
-#include <unistd.h>
 
+#include "numa_placement.h"
 #include "platform_atomics.h"
 
 /*
@@ -36,6 +34,7 @@ public:
   explicit SlidingQueue(size_t shared_size) {
     // std::cout << "shared_size: " << shared_size << "\n" << std::flush;
     shared = new T[shared_size];
+    NUMAPlace(shared, shared_size * sizeof(T));
     // std::cout << "shared sliding queue: " << shared << " ; "
     //           << static_cast<intptr_t>(reinterpret_cast<intptr_t>(shared))
     //           << "\n"
@@ -79,25 +78,11 @@ public:
   explicit QueueBuffer(SlidingQueue<T> &master, size_t given_size = 16384)
       : sq(master), local_size(given_size) {
     in = 0;
-    // how to replace this statement using numalib?
     local_queue = new T[local_size];
-    // const size_t objectSize = sizeof(T);
-    // void *memory = numa_alloc_onnode(local_size * objectSize, 1);
-
-    // for (int i = 0; i < 16384; ++i) {
-    //   void *objectMemory = static_cast<char *>(memory) + i * objectSize;
-    //   void *object = new (objectMemory) T;
-    // }
-    // local_queue = static_cast<T *>(memory);
-
-    // std::cout << "local size in constructor: " << local_size << "\n"
-    //           << std::flush;
+    NUMAPlace(local_queue, local_size * sizeof(T));
   }
 
-  ~QueueBuffer() {
-    delete[] local_queue;
-    // numa_free(local_queue, local_size * sizeof(T));
-  }
+  ~QueueBuffer() { delete[] local_queue; }
 
   void push_back(T to_add) {
     if (in == local_size)
@@ -0,0 +1,404 @@
+// Copyright (c) 2015, The Regents of the University of California (Regents)
+// See LICENSE.txt for license details
+
+#ifndef SPLIT_GRAPH_H_
+#define SPLIT_GRAPH_H_
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+
+#include "allocator.h"
+#include "graph.h"
+#include "numa_placement.h"
+#include "pvector.h"
+#include "util.h"
+
+
+/*
+GAP Benchmark Suite
+Class:  SplitCSRGraph
+
+Weighted CSR graph that keeps weights in an array parallel to the neighbor
+IDs (structure of arrays), instead of interleaved with them like a CSRGraph
+of NodeWeights
+ - out_neigh and in_neigh iterate neighbor IDs only, so traversals that only
+   need topology read half the bytes (even less for 64-bit IDs, since their
+   NodeWeights are padded)
+ - out_wneigh and in_wneigh iterate the two arrays together, yielding
+   NodeWeights, so weighted kernels read each edge's ID and weight
+ - Index is offsets (SGOffset) shared by both arrays, like the .wsg format,
+   which stores weights the same way (see sg_format.h)
+ - Made from a CSRGraph with FromCSR (in parallel), which consumes it,
+   splitting each direction's NodeWeights in place if the CSRGraph owns them
+   (only one direction's weights are allocated on top of it), otherwise
+   copying each direction and freeing it before the next
+ - Or loaded from a .wsg without conversion (Reader::LoadSplitGraph), in
+   which case its arrays can live in a memory-mapping of the file (storage
+   keeps it alive)
+ - Used as WGraph (benchmark.h)
+*/
+
+
+template <class NodeID_, class WeightT_, bool MakeInverse = true>
+class SplitCSRGraph {
+  // Used for *non-negative* offsets within a neighborhood
+  typedef std::make_unsigned<std::ptrdiff_t>::type OffsetT;
+
+ public:
+  typedef NodeWeight<NodeID_, WeightT_> WNode;
+
+  // Neighbor IDs of vertex, like CSRGraph's Neighborhood
+  class Neighborhood {
+    NodeID_ *g_index_;
+    NodeID_ *g_end_;
+
+   public:
+    Neighborhood(NodeID_ *begin, NodeID_ *end, OffsetT start_offset)
+        : g_index_(begin + std::min(start_offset, OffsetT(end - begin))),
+          g_end_(end) {}
+    typedef NodeID_* iterator;
+    iterator begin() { return g_index_; }
+    iterator end() { return g_end_; }
+  };
+
+  // Yields neighbors with their weights, reading both arrays
+  class witerator {
+   public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef WNode value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const WNode* pointer;
+    typedef WNode reference;
+
+    witerator(const NodeID_ *id, const WeightT_ *weight)
+        : id_(id), weight_(weight) {}
+
+    WNode operator*() const { return WNode(*id_, *weight_); }
+
+    witerator& operator++() {
+      id_++;
+      weight_++;
+      return *this;
+    }
+
+    witerator operator++(int) {
+      witerator old = *this;
+      ++(*this);
+      return old;
+    }
+
+    bool operator==(const witerator &other) const { return id_ == other.id_; }
+
+    bool operator!=(const witerator &other) const { return id_ != other.id_; }
+
+   private:
+    const NodeID_ *id_;
+    const WeightT_ *weight_;
+  };
+
+  class WNeighborhood {
+    witerator begin_;
+    witerator end_;
+
+   public:
+    WNeighborhood(const NodeID_ *ids, const WeightT_ *weights,
+                  SGOffset start, SGOffset end)
+        : begin_(ids + start, weights + start),
+          end_(ids + end, weights + end) {}
+    witerator begin() { return begin_; }
+    witerator end() { return end_; }
+  };
+
+  // Copies one direction of g (neigh(n) for every n, at offsets) into new
+  // arrays of offsets, IDs, and weights
+  template <typename NeighFunc>
+  static void SplitNeighborhoods(int64_t num_nodes,
+                                 const pvector<SGOffset> &offsets,
+                                 NeighFunc neigh, SGOffset **split_offsets,
+                                 NodeID_ **ids, WeightT_ **weights) {
+    const SGOffset num_edges = offsets[num_nodes];
+    *split_offsets = new SGOffset[num_nodes + 1];
+    std::copy(offsets.begin(), offsets.end(), *split_offsets);
+    *ids = new NodeID_[num_edges];
+    *weights = new WeightT_[num_edges];
+    NUMAPlaceNeighs(*ids, offsets.data(), num_nodes);
+    NUMAPlaceNeighs(*weights, offsets.data(), num_nodes);
+    AdviseArray(*ids, num_edges);
+    AdviseArray(*weights, num_edges);
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for (NodeID_ n = 0; n < num_nodes; n++) {
+      SGOffset e = offsets[n];
+      for (const WNode &wn : neigh(n)) {
+        (*ids)[e] = wn.v;
+        (*weights)[e] = wn.w;
+        e++;
+      }
+    }
+  }
+
+  // Splits num_edges NodeWeights (new[]'d, now owned by ids) in place:
+  // weights are copied out, then IDs are packed into the front of the same
+  // array, which is shrunk to fit. A NodeWeight is at least twice the size
+  // of an ID, so IDs of edges [k, 2k) only overwrite NodeWeights [0, k),
+  // which were already packed, and each doubling round can go in parallel.
+  static void SplitInPlace(WNode *neighs, SGOffset num_edges, NodeID_ **ids,
+                           WeightT_ **weights) {
+    static_assert(2 * sizeof(NodeID_) <= sizeof(WNode),
+                  "IDs must fit twice in a NodeWeight to pack in place");
+    *weights = new WeightT_[num_edges];
+    AdviseArray(*weights, num_edges);
+    #pragma omp parallel for
+    for (SGOffset e = 0; e < num_edges; e++)
+      (*weights)[e] = neighs[e].w;
+    NodeID_ *packed = reinterpret_cast<NodeID_*>(neighs);
+    if (num_edges > 0)
+      packed[0] = neighs[0].v;
+    for (SGOffset start = 1; start < num_edges; start *= 2) {
+      const SGOffset end = std::min(2 * start, num_edges);
+      #pragma omp parallel for if (end - start > 4096)
+      for (SGOffset e = start; e < end; e++)
+        packed[e] = neighs[e].v;
+    }
+    size_t new_size = std::max<SGOffset>(num_edges, 1) * sizeof(NodeID_);
+    *ids = static_cast<NodeID_*>(std::realloc(neighs, new_size));
+    if (*ids == nullptr) {
+      std::cout << "Call to realloc() failed" << std::endl;
+      exit(-33);
+    }
+  }
+
+  // Splits one direction of g, in place if g hands over its neighbors and
+  // they aren't placed on NUMA nodes by vertex range (packing would move
+  // IDs off their nodes), otherwise by copying and then freeing them
+  template <typename CSRGraphT_>
+  static void SplitDirection(CSRGraphT_ &g, bool in_graph,
+                             SGOffset **split_offsets, NodeID_ **ids,
+                             WeightT_ **weights) {
+    const int64_t num_nodes = g.num_nodes();
+    pvector<SGOffset> offsets = g.VertexOffsets(in_graph);
+    WNode *neighs = g.ReleaseNeighbors(in_graph);
+    if ((neighs != nullptr) && !NUMAPlacementActive()) {
+      *split_offsets = new SGOffset[num_nodes + 1];
+      std::copy(offsets.begin(), offsets.end(), *split_offsets);
+      SplitInPlace(neighs, offsets[num_nodes], ids, weights);
+      return;
+    }
+    if constexpr (MakeInverse) {
+      if (in_graph)
+        SplitNeighborhoods(num_nodes, offsets,
+                           [&g](NodeID_ n) { return g.in_neigh(n); },
+                           split_offsets, ids, weights);
+    }
+    if (!in_graph)
+      SplitNeighborhoods(num_nodes, offsets,
+                         [&g](NodeID_ n) { return g.out_neigh(n); },
+                         split_offsets, ids, weights);
+    if (neighs != nullptr)
+      delete[] neighs;
+  }
+
+  // Consumes g (a CSRGraph of NodeWeights), its inverse is made first if
+  // needed since it's made from the out neighbors
+  template <typename CSRGraphT_>
+  static SplitCSRGraph FromCSR(CSRGraphT_ &&g) {
+    static_assert(!std::is_lvalue_reference<CSRGraphT_>::value,
+                  "FromCSR takes over the graph's neighbors, move it in");
+    SGOffset *out_offsets, *in_offsets = nullptr;
+    NodeID_ *out_ids, *in_ids = nullptr;
+    WeightT_ *out_weights, *in_weights = nullptr;
+    const int64_t num_nodes = g.num_nodes();
+    if (!g.directed()) {
+      SplitDirection(g, false, &out_offsets, &out_ids, &out_weights);
+      return SplitCSRGraph(num_nodes, out_offsets, out_ids, out_weights);
+    }
+    if constexpr (MakeInverse) {
+      g.PrepareInverse();
+      SplitDirection(g, true, &in_offsets, &in_ids, &in_weights);
+    }
+    SplitDirection(g, false, &out_offsets, &out_ids, &out_weights);
+    return SplitCSRGraph(num_nodes, out_offsets, out_ids, out_weights,
+                         in_offsets, in_ids, in_weights);
+  }
+
+  SplitCSRGraph()
+      : directed_(false), num_nodes_(-1), num_edges_(-1),
+        out_offsets_(nullptr), out_ids_(nullptr), out_weights_(nullptr),
+        in_offsets_(nullptr), in_ids_(nullptr), in_weights_(nullptr) {}
+
+  // Takes ownership of (new[]'d) arrays, unless they live inside storage
+  SplitCSRGraph(int64_t num_nodes, SGOffset *offsets, NodeID_ *ids,
+                WeightT_ *weights, std::shared_ptr<void> storage = nullptr)
+      : directed_(false), num_nodes_(num_nodes), out_offsets_(offsets),
+        out_ids_(ids), out_weights_(weights), in_offsets_(offsets),
+        in_ids_(ids), in_weights_(weights), storage_(storage) {
+    num_edges_ = out_offsets_[num_nodes_] / 2;
+  }
+
+  SplitCSRGraph(int64_t num_nodes, SGOffset *out_offsets, NodeID_ *out_ids,
+                WeightT_ *out_weights, SGOffset *in_offsets, NodeID_ *in_ids,
+                WeightT_ *in_weights, std::shared_ptr<void> storage = nullptr)
+      : directed_(true), num_nodes_(num_nodes), out_offsets_(out_offsets),
+        out_ids_(out_ids), out_weights_(out_weights), in_offsets_(in_offsets),
+        in_ids_(in_ids), in_weights_(in_weights), storage_(storage) {
+    num_edges_ = out_offsets_[num_nodes_];
+  }
+
+  SplitCSRGraph(SplitCSRGraph &&other)
+      : directed_(other.directed_), num_nodes_(other.num_nodes_),
+        num_edges_(other.num_edges_), out_offsets_(other.out_offsets_),
+        out_ids_(other.out_ids_), out_weights_(other.out_weights_),
+        in_offsets_(other.in_offsets_), in_ids_(other.in_ids_),
+        in_weights_(other.in_weights_), storage_(std::move(other.storage_)) {
+    other.num_edges_ = -1;
+    other.num_nodes_ = -1;
+    other.out_offsets_ = nullptr;
+    other.out_ids_ = nullptr;
+    other.out_weights_ = nullptr;
+    other.in_offsets_ = nullptr;
+    other.in_ids_ = nullptr;
+    other.in_weights_ = nullptr;
+  }
+
+  ~SplitCSRGraph() { ReleaseResources(); }
+
+  SplitCSRGraph& operator=(SplitCSRGraph &&other) {
+    if (this != &other) {
+      ReleaseResources();
+      directed_ = other.directed_;
+      num_edges_ = other.num_edges_;
+      num_nodes_ = other.num_nodes_;
+      out_offsets_ = other.out_offsets_;
+      out_ids_ = other.out_ids_;
+      out_weights_ = other.out_weights_;
+      in_offsets_ = other.in_offsets_;
+      in_ids_ = other.in_ids_;
+      in_weights_ = other.in_weights_;
+      storage_ = std::move(other.storage_);
+      other.num_edges_ = -1;
+      other.num_nodes_ = -1;
+      other.out_offsets_ = nullptr;
+      other.out_ids_ = nullptr;
+      other.out_weights_ = nullptr;
+      other.in_offsets_ = nullptr;
+      other.in_ids_ = nullptr;
+      other.in_weights_ = nullptr;
+    }
+    return *this;
+  }
+
+  bool directed() const { return directed_; }
+
+  int64_t num_nodes() const { return num_nodes_; }
+
+  int64_t num_edges() const { return num_edges_; }
+
+  int64_t num_edges_directed() const {
+    return directed_ ? num_edges_ : 2 * num_edges_;
+  }
+
+  int64_t out_degree(NodeID_ v) const {
+    return out_offsets_[v + 1] - out_offsets_[v];
+  }
+
+  int64_t in_degree(NodeID_ v) const {
+    static_assert(MakeInverse, "Graph inversion disabled but reading inverse");
+    return in_offsets_[v + 1] - in_offsets_[v];
+  }
+
+  Neighborhood out_neigh(NodeID_ n, OffsetT start_offset = 0) const {
+    return Neighborhood(out_ids_ + out_offsets_[n],
+                        out_ids_ + out_offsets_[n + 1], start_offset);
+  }
+
+  Neighborhood in_neigh(NodeID_ n, OffsetT start_offset = 0) const {
+    static_assert(MakeInverse, "Graph inversion disabled but reading inverse");
+    return Neighborhood(in_ids_ + in_offsets_[n],
+                        in_ids_ + in_offsets_[n + 1], start_offset);
+  }
+
+  WNeighborhood out_wneigh(NodeID_ n) const {
+    return WNeighborhood(out_ids_, out_weights_, out_offsets_[n],
+                         out_offsets_[n + 1]);
+  }
+
+  WNeighborhood in_wneigh(NodeID_ n) const {
+    static_assert(MakeInverse, "Graph inversion disabled but reading inverse");
+    return WNeighborhood(in_ids_, in_weights_, in_offsets_[n],
+                         in_offsets_[n + 1]);
+  }
+
+  // Inverse is always made along with the graph (same interface as CSR)
+  int64_t prepared_in_degree(NodeID_ v) const { return in_degree(v); }
+
+  Neighborhood prepared_in_neigh(NodeID_ n, OffsetT start_offset = 0) const {
+    return in_neigh(n, start_offset);
+  }
+
+  void PrepareInverse() const {
+    static_assert(MakeInverse, "Graph inversion disabled but reading inverse");
+  }
+
+  bool inverse_ready() const { return true; }
+
+  void PrintStats() const {
+    std::cout << "Graph has " << num_nodes_ << " nodes and " << num_edges_
+              << " ";
+    if (!directed_)
+      std::cout << "un";
+    std::cout << "directed edges for degree: ";
+    std::cout << num_edges_ / num_nodes_ << "\n" << std::flush;
+  }
+
+  void PrintTopology() const {
+    for (NodeID_ i = 0; i < num_nodes_; i++) {
+      std::cout << i << ": ";
+      for (WNode wn : out_wneigh(i)) {
+        std::cout << wn << " ";
+      }
+      std::cout << std::endl;
+    }
+  }
+
+  Range<NodeID_> vertices() const { return Range<NodeID_>(num_nodes()); }
+
+ private:
+  void ReleaseResources() {
+    if (storage_ != nullptr) {
+      storage_.reset();
+      return;
+    }
+    if (out_offsets_ != nullptr)
+      delete[] out_offsets_;
+    if (out_ids_ != nullptr)
+      delete[] out_ids_;
+    if (out_weights_ != nullptr)
+      delete[] out_weights_;
+    if (directed_) {
+      if (in_offsets_ != nullptr)
+        delete[] in_offsets_;
+      if (in_ids_ != nullptr)
+        delete[] in_ids_;
+      if (in_weights_ != nullptr)
+        delete[] in_weights_;
+    }
+  }
+
+  bool directed_;
+  int64_t num_nodes_;
+  int64_t num_edges_;
+  SGOffset *out_offsets_;
+  NodeID_ *out_ids_;
+  WeightT_ *out_weights_;
+  SGOffset *in_offsets_;
+  NodeID_ *in_ids_;
+  WeightT_ *in_weights_;
+  std::shared_ptr<void> storage_;
+};
+
+#endif  // SPLIT_GRAPH_H_
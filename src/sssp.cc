@@ -5,9 +5,12 @@
 #include <iostream>
 #include <limits>
 #include <queue>
+#include <type_traits>
 #include <vector>
 #include <unistd.h> 
 
+// Only outgoing neighbors are used, so no inverse is made
+#define GAPBS_GRAPH_NEEDS kNeedsSquished
 #include "benchmark.h"
 #include "builder.h"
 #include "command_line.h"
@@ -24,7 +27,9 @@ Author: Scott Beamer, Yunming Zhang
 Returns array of distances for all vertices from given source vertex
 
 This SSSP implementation makes use of the ∆-stepping algorithm [1]. The type
-used for weights and distances (WeightT) is typedefined in benchmark.h. The
+used for weights (WeightT) is typedefined in benchmark.h, and can be picked
+at build time (e.g. make WEIGHT=uint8). Distances are the same type, except
+for 8 or 16-bit weights, whose distances are 32-bit (DistanceT). The
 delta parameter (-d) should be set for each input graph. This implementation
 incorporates a new bucket fusion optimization [2] that significantly reduces
 the number of iterations (& barriers) needed.
@@ -60,16 +65,26 @@ Generation and Optimization (CGO), pages 158-170, 2020.
 
 using namespace std;
 
-const WeightT kDistInf = numeric_limits<WeightT>::max() / 2;
+// Narrow weights would overflow as distances, so they sum into int32_t
+template <typename WeightT_>
+using DistanceT = typename conditional<is_integral<WeightT_>::value &&
+                                       (sizeof(WeightT_) < sizeof(int32_t)),
+                                       int32_t, WeightT_>::type;
+typedef DistanceT<WeightT> DistT;
+
+template <typename DistT_>
+const DistT_ kDistInf = numeric_limits<DistT_>::max() / 2;
 const size_t kMaxBin = numeric_limits<size_t>::max() / 2;
 const size_t kBinSizeThreshold = 1000;
 
-inline void RelaxEdges(const WGraph &g, NodeID u, WeightT delta,
-                       pvector<WeightT> &dist,
+template <typename WeightT_>
+inline void RelaxEdges(const WeightedGraph<WeightT_> &g, NodeID u,
+                       DistanceT<WeightT_> delta,
+                       pvector<DistanceT<WeightT_>> &dist,
                        vector<vector<NodeID>> &local_bins) {
-  for (WNode wn : g.out_neigh(u)) {
-    WeightT old_dist = dist[wn.v];
-    WeightT new_dist = dist[u] + wn.w;
+  for (NodeWeight<NodeID, WeightT_> wn : g.out_wneigh(u)) {
+    DistanceT<WeightT_> old_dist = dist[wn.v];
+    DistanceT<WeightT_> new_dist = dist[u] + wn.w;
     while (new_dist < old_dist) {
       if (compare_and_swap(dist[wn.v], old_dist, new_dist)) {
         size_t dest_bin = new_dist / delta;
@@ -83,9 +98,13 @@ inline void RelaxEdges(const WGraph &g, NodeID u, WeightT delta,
   }
 }
 
-pvector<WeightT> DeltaStep(const WGraph &g, NodeID source, WeightT delta) {
+template <typename WeightT_>
+pvector<DistanceT<WeightT_>> DeltaStep(const WeightedGraph<WeightT_> &g,
+                                       NodeID source,
+                                       DistanceT<WeightT_> delta) {
+  typedef DistanceT<WeightT_> DistT_;
   Timer t;
-  pvector<WeightT> dist(g.num_nodes(), kDistInf);
+  pvector<DistT_> dist(g.num_nodes(), kDistInf<DistT_>);
   dist[source] = 0;
   pvector<NodeID> frontier(g.num_edges_directed());
   // two element arrays for double buffering curr=iter&1, next=(iter+1)&1
@@ -105,7 +124,7 @@ pvector<WeightT> DeltaStep(const WGraph &g, NodeID source, WeightT delta) {
 #pragma omp for nowait schedule(dynamic, 64)
       for (size_t i = 0; i < curr_frontier_tail; i++) {
         NodeID u = frontier[i];
-        if (dist[u] >= delta * static_cast<WeightT>(curr_bin_index))
+        if (dist[u] >= delta * static_cast<DistT_>(curr_bin_index))
           RelaxEdges(g, u, delta, dist, local_bins);
       }
       while (curr_bin_index < local_bins.size() &&
@@ -148,27 +167,27 @@ pvector<WeightT> DeltaStep(const WGraph &g, NodeID source, WeightT delta) {
   return dist;
 }
 
-void PrintSSSPStats(const WGraph &g, const pvector<WeightT> &dist) {
-  auto NotInf = [](WeightT d) { return d != kDistInf; };
+void PrintSSSPStats(const WGraph &g, const pvector<DistT> &dist) {
+  auto NotInf = [](DistT d) { return d != kDistInf<DistT>; };
   int64_t num_reached = count_if(dist.begin(), dist.end(), NotInf);
   cout << "SSSP Tree reaches " << num_reached << " nodes" << endl;
 }
 
 // Compares against simple serial implementation
 bool SSSPVerifier(const WGraph &g, NodeID source,
-                  const pvector<WeightT> &dist_to_test) {
+                  const pvector<DistT> &dist_to_test) {
   // Serial Dijkstra implementation to get oracle distances
-  pvector<WeightT> oracle_dist(g.num_nodes(), kDistInf);
+  pvector<DistT> oracle_dist(g.num_nodes(), kDistInf<DistT>);
   oracle_dist[source] = 0;
-  typedef pair<WeightT, NodeID> WN;
+  typedef pair<DistT, NodeID> WN;
   priority_queue<WN, vector<WN>, greater<WN>> mq;
   mq.push(make_pair(0, source));
   while (!mq.empty()) {
-    WeightT td = mq.top().first;
+    DistT td = mq.top().first;
     NodeID u = mq.top().second;
     mq.pop();
     if (td == oracle_dist[u]) {
-      for (WNode wn : g.out_neigh(u)) {
+      for (WNode wn : g.out_wneigh(u)) {
         if (td + wn.w < oracle_dist[wn.v]) {
           oracle_dist[wn.v] = td + wn.w;
           mq.push(make_pair(td + wn.w, wn.v));
@@ -200,7 +219,7 @@ bool SSSPVerifier(const WGraph &g, NodeID source,
 
 int main(int argc, char *argv[]) {
   GetCurTime("whole start");
-  CLDelta<WeightT> cli(argc, argv, "single-source shortest-path");
+  CLDelta<DistT> cli(argc, argv, "single-source shortest-path");
   if (!cli.ParseArgs())
     return -1;
   WeightedBuilder b(cli);
@@ -210,7 +229,7 @@ int main(int argc, char *argv[]) {
     return DeltaStep(g, sp.PickNext(), cli.delta());
   };
   SourcePicker<WGraph> vsp(g, cli.start_vertex());
-  auto VerifierBound = [&vsp](const WGraph &g, const pvector<WeightT> &dist) {
+  auto VerifierBound = [&vsp](const WGraph &g, const pvector<DistT> &dist) {
     return SSSPVerifier(g, vsp.PickNext(), dist);
   };
   
@@ -12,6 +12,8 @@
 #include <vector>
 #include <unistd.h> 
 
+// Only outgoing neighbors are used, and they must be sorted and squished
+#define GAPBS_GRAPH_NEEDS (kNeedsSorted | kNeedsSquished)
 #include "benchmark.h"
 #include "builder.h"
 #include "command_line.h"
@@ -31,8 +33,8 @@ Requires input graph:
   - no duplicate edges (or else will be counted as multiple triangles)
   - neighborhoods are sorted by vertex identifiers
 
-Other than symmetrizing, the rest of the requirements are done by SquishCSR
-during graph building.
+Other than symmetrizing, the rest of the requirements are done by
+SquishCSRInPlace during graph building.
 
 This implementation reduces the search space by counting each triangle only
 once. A naive implementation will count the same triangle six times because
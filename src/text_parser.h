@@ -0,0 +1,214 @@
+// Copyright (c) 2015, The Regents of the University of California (Regents)
+// See LICENSE.txt for license details
+
+#ifndef TEXT_PARSER_H_
+#define TEXT_PARSER_H_
+
+#include <algorithm>
+#include <charconv>
+#include <cinttypes>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+#include "pvector.h"
+
+
+/*
+GAP Benchmark Suite
+File:   Text Parser
+
+Helpers for parsing line-oriented text graph formats in parallel
+ - Input is a range of bytes (e.g. from a MappedFile), which is split into
+   chunks at newline boundaries so each thread parses whole lines
+ - ParseLines counts lines first, so results are written directly into a
+   pvector grown once per call and compacted only if some lines produced
+   fewer items
+ - Number parsing is a hand-written fast path (no locale or stream state)
+   that, like operator>>, stops at the first character not part of a number,
+   floating-point numbers (e.g. weights) use std::from_chars
+*/
+
+
+inline bool IsLineSpace(char c) {
+  return (c == ' ') || (c == '\t') || (c == '\r');
+}
+
+inline const char* SkipLineSpace(const char *p, const char *end) {
+  while ((p < end) && IsLineSpace(*p))
+    p++;
+  return p;
+}
+
+// Returns position after parsed integer, or nullptr if none found
+template <typename T_>
+inline const char* ParseInt(const char *p, const char *end, T_ &val) {
+  p = SkipLineSpace(p, end);
+  bool negative = false;
+  if ((p < end) && ((*p == '-') || (*p == '+'))) {
+    negative = *p == '-';
+    p++;
+  }
+  if ((p == end) || (static_cast<unsigned>(*p - '0') > 9))
+    return nullptr;
+  uint64_t x = 0;
+  while ((p < end) && (static_cast<unsigned>(*p - '0') <= 9)) {
+    x = x*10 + (*p - '0');
+    p++;
+  }
+  val = negative ? -static_cast<T_>(x) : static_cast<T_>(x);
+  return p;
+}
+
+// Like ParseInt, but floating-point types also parse fractions and exponents
+template <typename T_>
+inline const char* ParseNumber(const char *p, const char *end, T_ &val) {
+  if constexpr (std::is_floating_point<T_>::value) {
+    p = SkipLineSpace(p, end);
+    if ((p < end) && (*p == '+'))
+      p++;
+    std::from_chars_result result = std::from_chars(p, end, val);
+    return result.ec == std::errc() ? result.ptr : nullptr;
+  } else {
+    return ParseInt(p, end, val);
+  }
+}
+
+// Number of whitespace-separated tokens in [p, end)
+inline int64_t CountTokens(const char *p, const char *end) {
+  int64_t tokens = 0;
+  bool in_token = false;
+  for (; p < end; p++) {
+    bool is_space = IsLineSpace(*p);
+    tokens += !is_space && !in_token;
+    in_token = !is_space;
+  }
+  return tokens;
+}
+
+// Whether line [p, line_end) is a comment starting with comment_char
+inline bool IsCommentLine(const char *p, const char *line_end,
+                          char comment_char = '%') {
+  p = SkipLineSpace(p, line_end);
+  return (p != line_end) && (*p == comment_char);
+}
+
+// Returns end of line starting at p (position of '\n' or end)
+inline const char* FindLineEnd(const char *p, const char *end) {
+  const void *newline = std::memchr(p, '\n', end - p);
+  return newline ? static_cast<const char*>(newline) : end;
+}
+
+inline int64_t CountLines(const char *begin, const char *end) {
+  if (begin == end)
+    return 0;
+  int64_t newlines = std::count(begin, end, '\n');
+  return newlines + (end[-1] != '\n' ? 1 : 0);
+}
+
+inline int DefaultNumChunks(size_t num_bytes) {
+  int num_threads = 1;
+  #ifdef _OPENMP
+    num_threads = omp_get_max_threads();
+  #endif
+  const size_t min_chunk_bytes = 1 << 16;
+  size_t max_chunks = std::max(num_bytes / min_chunk_bytes, size_t(1));
+  return std::min(size_t(8 * num_threads), max_chunks);
+}
+
+// Returns num_chunks+1 boundaries (some chunks may be empty) that each
+// start at the beginning of a line
+inline std::vector<const char*> SplitAtNewlines(const char *begin,
+                                                const char *end,
+                                                int num_chunks) {
+  std::vector<const char*> bounds(num_chunks + 1);
+  bounds[0] = begin;
+  size_t chunk_bytes = (end - begin) / num_chunks;
+  for (int c = 1; c < num_chunks; c++) {
+    const char *guess = std::max(begin + c*chunk_bytes, bounds[c-1]);
+    const char *line_end = FindLineEnd(guess, end);
+    bounds[c] = line_end == end ? end : line_end + 1;
+  }
+  bounds[num_chunks] = end;
+  return bounds;
+}
+
+inline void ExitMalformedLine(const char *line, const char *end) {
+  const char *line_end = FindLineEnd(line, end);
+  std::cout << "Malformed line: " << std::string(line, line_end) << std::endl;
+  std::exit(-27);
+}
+
+/*
+Parses every line of [begin, end) with parse_line in parallel, appending the
+results to items
+ - parse_line(line, line_end, out) writes up to max_per_line items to out
+   and returns how many it wrote, or -1 if the line is malformed
+ - Blank lines and comment lines (starting with # or %) are skipped
+ - Items are appended in the same order as the lines they came from, so a
+   file can be parsed a range of whole lines at a time into the same items
+*/
+template <typename T_, class Alloc_, typename LineParser>
+void ParseLines(const char *begin, const char *end, int max_per_line,
+                LineParser parse_line, pvector<T_, Alloc_> &items) {
+  const int num_chunks = DefaultNumChunks(end - begin);
+  std::vector<const char*> bounds = SplitAtNewlines(begin, end, num_chunks);
+  pvector<int64_t> chunk_starts(num_chunks + 1);
+  #pragma omp parallel for schedule(dynamic, 1)
+  for (int c = 0; c < num_chunks; c++)
+    chunk_starts[c] = CountLines(bounds[c], bounds[c+1]) * max_per_line;
+  int64_t total = items.size();
+  for (int c = 0; c < num_chunks; c++) {
+    int64_t chunk_size = chunk_starts[c];
+    chunk_starts[c] = total;
+    total += chunk_size;
+  }
+  chunk_starts[num_chunks] = total;
+  const int64_t num_before = items.size();
+  items.resize(total);
+  pvector<int64_t> chunk_found(num_chunks);
+  const char *malformed = nullptr;
+  #pragma omp parallel for schedule(dynamic, 1)
+  for (int c = 0; c < num_chunks; c++) {
+    T_ *out = items.data() + chunk_starts[c];
+    int64_t found = 0;
+    const char *line = bounds[c];
+    while (line < bounds[c+1]) {
+      const char *line_end = FindLineEnd(line, bounds[c+1]);
+      const char *p = SkipLineSpace(line, line_end);
+      if ((p != line_end) && (*p != '#') && (*p != '%')) {
+        int num_parsed = parse_line(p, line_end, out + found);
+        if (num_parsed < 0) {
+          #pragma omp critical
+          if ((malformed == nullptr) || (line < malformed))
+            malformed = line;
+          break;
+        }
+        found += num_parsed;
+      }
+      line = line_end + 1;
+    }
+    chunk_found[c] = found;
+  }
+  if (malformed != nullptr)
+    ExitMalformedLine(malformed, end);
+  // close gaps left by lines that produced fewer than max_per_line items
+  int64_t num_items = num_before;
+  for (int c = 0; c < num_chunks; c++) {
+    if (num_items != chunk_starts[c])
+      std::memmove(static_cast<void*>(items.data() + num_items),
+                   items.data() + chunk_starts[c],
+                   chunk_found[c] * sizeof(T_));
+    num_items += chunk_found[c];
+  }
+  items.resize(num_items);
+}
+
+#endif  // TEXT_PARSER_H_
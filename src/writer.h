@@ -5,12 +5,18 @@
 #define WRITER_H_
 
 #include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <string>
 #include <type_traits>
+#include <vector>
 
+#include "bel_format.h"
+#include "compressed_graph.h"
 #include "graph.h"
+#include "pvector.h"
+#include "sg_format.h"
 
 
 /*
@@ -21,13 +27,33 @@ Author: Scott Beamer
 Given filename and graph, writes out the graph to storage
  - Should use WriteGraph(filename, serialized)
  - If serialized, will write out as serialized graph, otherwise, as edgelist
+ - Edge list is written in binary (see bel_format.h) if filename ends with
+   .bel or .bwel (with weights)
+ - Serialized graphs are written in the latest version of the format and
+   can optionally include checksums of each section, and if unweighted, can
+   have their neighbors compressed
+ - Weighted serialized graphs (.wsg) store each direction's weights in their
+   own section, apart from the neighbor IDs (like SplitCSRGraph)
+ - Directed graphs without inverses (invert false) are serialized without
+   inverse sections, readers that need them make them (see CSRGraph)
 */
 
 
-template <typename NodeID_, typename DestID_ = NodeID_>
+template <typename NodeID_, typename DestID_ = NodeID_, bool invert = true,
+          bool lazy_inverse = false>
 class WriterBase {
+  // Type of DestID_'s weight (unused if unweighted)
+  template <typename T_>
+  struct WeightOf { typedef NodeID_ type; };
+
+  template <typename WeightT_>
+  struct WeightOf<NodeWeight<NodeID_, WeightT_>> { typedef WeightT_ type; };
+
+  typedef typename WeightOf<DestID_>::type WeightT;
+  typedef CSRGraph<NodeID_, DestID_, invert, lazy_inverse> CSRGraphT;
+
  public:
-  explicit WriterBase(CSRGraph<NodeID_, DestID_> &g) : g_(g) {}
+  explicit WriterBase(CSRGraphT &g) : g_(g) {}
 
   void WriteEL(std::fstream &out) {
     for (NodeID_ u=0; u < g_.num_nodes(); u++) {
@@ -36,39 +62,147 @@ class WriterBase {
     }
   }
 
-  void WriteSerializedGraph(std::fstream &out) {
-    if (!std::is_same<NodeID_, SGID>::value) {
-      std::cout << "serialized graphs only allowed for 32b IDs" << std::endl;
+  // Records are filled in parallel (at each vertex's offset into the edge
+  // list) and then written out with one write
+  void WriteBinaryEL(std::fstream &out, bool weighted) {
+    bool graph_weighted = !std::is_same<DestID_, NodeID_>::value;
+    if (weighted && !graph_weighted) {
+      std::cout << ".bwel requires a weighted graph (use -w)" << std::endl;
+      std::exit(-12);
+    }
+    BELHeader header = BELHeader();
+    std::memcpy(header.magic, kBELMagic, sizeof(kBELMagic));
+    header.version = kBELVersion;
+    header.id_bytes = sizeof(NodeID_);
+    header.weight_bytes = weighted ? sizeof(WeightT) : 0;
+    header.weight_kind = weighted ? SGWeightKindOf<WeightT>() : 0;
+    header.num_edges = g_.num_edges_directed();
+    const size_t record_bytes = header.record_bytes();
+    const size_t dest_bytes = record_bytes - sizeof(NodeID_);
+    pvector<SGOffset> offsets = g_.VertexOffsets(false);
+    pvector<char> records(header.num_edges * record_bytes);
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for (NodeID_ u=0; u < g_.num_nodes(); u++) {
+      char *record = records.data() + offsets[u] * record_bytes;
+      for (const DestID_ &v : g_.out_neigh(u)) {
+        std::memcpy(record, &u, sizeof(NodeID_));
+        std::memcpy(record + sizeof(NodeID_), &v, dest_bytes);
+        record += record_bytes;
+      }
+    }
+    out.write(reinterpret_cast<char*>(&header), sizeof(BELHeader));
+    out.write(records.data(), records.size());
+  }
+
+  // Writes version 2 format (see sg_format.h) with sections page-aligned
+  void WriteSerializedGraph(std::fstream &out, bool checksums = false,
+                            bool compressed = false) {
+    if ((sizeof(NodeID_) != sizeof(int32_t)) &&
+        (sizeof(NodeID_) != sizeof(int64_t))) {
+      std::cout << "serialized graphs only allowed for 32 or 64b IDs"
+                << std::endl;
       std::exit(-4);
     }
-    if (!std::is_same<DestID_, NodeID_>::value &&
-        !std::is_same<DestID_, NodeWeight<NodeID_, SGID>>::value) {
-      std::cout << ".wsg only allowed for int32_t weights" << std::endl;
-      std::exit(-8);
+    bool weighted = !std::is_same<DestID_, NodeID_>::value;
+    if (compressed && weighted) {
+      std::cout << "compressed serialized graphs must be unweighted"
+                << std::endl;
+      std::exit(-14);
     }
     bool directed = g_.directed();
     SGOffset num_nodes = g_.num_nodes();
     SGOffset edges_to_write = g_.num_edges_directed();
-    std::streamsize index_bytes = (num_nodes+1) * sizeof(SGOffset);
-    std::streamsize neigh_bytes;
-    if (std::is_same<DestID_, NodeID_>::value)
-      neigh_bytes = edges_to_write * sizeof(SGID);
-    else
-      neigh_bytes = edges_to_write * sizeof(NodeWeight<NodeID_, SGID>);
-    out.write(reinterpret_cast<char*>(&directed), sizeof(bool));
-    out.write(reinterpret_cast<char*>(&edges_to_write), sizeof(SGOffset));
-    out.write(reinterpret_cast<char*>(&num_nodes), sizeof(SGOffset));
-    pvector<SGOffset> offsets = g_.VertexOffsets(false);
-    out.write(reinterpret_cast<char*>(offsets.data()), index_bytes);
-    out.write(reinterpret_cast<char*>(g_.out_neigh(0).begin()), neigh_bytes);
-    if (directed) {
-      offsets = g_.VertexOffsets(true);
-      out.write(reinterpret_cast<char*>(offsets.data()), index_bytes);
-      out.write(reinterpret_cast<char*>(g_.in_neigh(0).begin()), neigh_bytes);
+    uint64_t index_bytes = (num_nodes+1) * sizeof(SGOffset);
+    uint64_t neigh_bytes = edges_to_write * sizeof(DestID_);
+    SGHeader header = SGHeader();
+    std::memcpy(header.magic, kSGMagic, sizeof(kSGMagic));
+    header.version = kSGVersion;
+    header.flags = (directed ? kSGDirected : 0) |
+                   (weighted ? kSGWeighted : 0) |
+                   (checksums ? kSGChecksums : 0) |
+                   (compressed ? kSGCompressed : 0);
+    header.id_bytes = sizeof(NodeID_);
+    header.weight_bytes = weighted ? sizeof(WeightT) : 0;
+    header.weight_kind = weighted ? SGWeightKindOf<WeightT>() : 0;
+    header.num_nodes = num_nodes;
+    header.num_edges = edges_to_write;
+    pvector<SGOffset> out_offsets = g_.VertexOffsets(false);
+    pvector<SGOffset> in_offsets;
+    pvector<NodeID_> out_ids, in_ids;
+    pvector<WeightT> out_weights, in_weights;
+    typename CompressedCSRGraph<NodeID_>::OffsetVector out_byte_offsets,
+                                                       in_byte_offsets;
+    typename CompressedCSRGraph<NodeID_>::ByteVector out_bytes, in_bytes;
+    std::vector<const void*> sources;
+    AddSection(header, kSGOutOffsets, sizeof(SGOffset), index_bytes);
+    sources.push_back(out_offsets.data());
+    if (compressed) {
+      CompressedCSRGraph<NodeID_>::EncodeNeighborhoods(num_nodes,
+          [this](NodeID_ n) { return g_.out_neigh(n); }, out_byte_offsets,
+          out_bytes);
+      AddSection(header, kSGOutByteOffsets, sizeof(SGOffset), index_bytes);
+      sources.push_back(out_byte_offsets.data());
+      AddSection(header, kSGOutCompressed, 1, out_bytes.size());
+      sources.push_back(out_bytes.data());
+    } else if (weighted) {
+      SplitWeights(g_.out_neigh(0).begin(), edges_to_write, out_ids,
+                   out_weights);
+      AddSection(header, kSGOutNeighs, sizeof(NodeID_), out_ids.size() *
+                 sizeof(NodeID_));
+      sources.push_back(out_ids.data());
+      AddSection(header, kSGOutWeights, sizeof(WeightT), out_weights.size() *
+                 sizeof(WeightT));
+      sources.push_back(out_weights.data());
+    } else {
+      AddSection(header, kSGOutNeighs, sizeof(DestID_), neigh_bytes);
+      sources.push_back(g_.out_neigh(0).begin());
+    }
+    if constexpr (invert) {
+      if (directed) {
+        in_offsets = g_.VertexOffsets(true);
+        AddSection(header, kSGInOffsets, sizeof(SGOffset), index_bytes);
+        sources.push_back(in_offsets.data());
+        if (compressed) {
+          CompressedCSRGraph<NodeID_>::EncodeNeighborhoods(num_nodes,
+              [this](NodeID_ n) { return g_.in_neigh(n); }, in_byte_offsets,
+              in_bytes);
+          AddSection(header, kSGInByteOffsets, sizeof(SGOffset), index_bytes);
+          sources.push_back(in_byte_offsets.data());
+          AddSection(header, kSGInCompressed, 1, in_bytes.size());
+          sources.push_back(in_bytes.data());
+        } else if (weighted) {
+          SplitWeights(g_.in_neigh(0).begin(), edges_to_write, in_ids,
+                       in_weights);
+          AddSection(header, kSGInNeighs, sizeof(NodeID_), in_ids.size() *
+                     sizeof(NodeID_));
+          sources.push_back(in_ids.data());
+          AddSection(header, kSGInWeights, sizeof(WeightT),
+                     in_weights.size() * sizeof(WeightT));
+          sources.push_back(in_weights.data());
+        } else {
+          AddSection(header, kSGInNeighs, sizeof(DestID_), neigh_bytes);
+          sources.push_back(g_.in_neigh(0).begin());
+        }
+      }
+    }
+    if (checksums) {
+      for (uint32_t i = 0; i < header.num_sections; i++)
+        header.sections[i].checksum = SGChecksum(sources[i],
+                                                 header.sections[i].bytes);
+    }
+    uint64_t pos = 0;
+    out.write(reinterpret_cast<char*>(&header), sizeof(SGHeader));
+    pos += sizeof(SGHeader);
+    for (uint32_t i = 0; i < header.num_sections; i++) {
+      WritePadding(out, header.sections[i].offset - pos);
+      out.write(static_cast<const char*>(sources[i]),
+                header.sections[i].bytes);
+      pos = header.sections[i].offset + header.sections[i].bytes;
     }
   }
 
-  void WriteGraph(std::string filename, bool serialized = false) {
+  void WriteGraph(std::string filename, bool serialized = false,
+                  bool checksums = false, bool compressed = false) {
     if (filename == "") {
       std::cout << "No output filename given (Use -h for help)" << std::endl;
       std::exit(-8);
@@ -78,15 +212,59 @@ class WriterBase {
       std::cout << "Couldn't write to file " << filename << std::endl;
       std::exit(-5);
     }
+    std::size_t suff_pos = filename.rfind('.');
+    std::string suffix = suff_pos == std::string::npos ? "" :
+                         filename.substr(suff_pos);
     if (serialized)
-      WriteSerializedGraph(file);
+      WriteSerializedGraph(file, checksums, compressed);
+    else if ((suffix == ".bel") || (suffix == ".bwel"))
+      WriteBinaryEL(file, suffix == ".bwel");
     else
       WriteEL(file);
     file.close();
   }
 
  private:
-  CSRGraph<NodeID_, DestID_> &g_;
+  // Copies neighbors' IDs and weights out into separate arrays
+  static void SplitWeights(const DestID_ *neighs, int64_t num_edges,
+                           pvector<NodeID_> &ids, pvector<WeightT> &weights) {
+    if constexpr (!std::is_same<DestID_, NodeID_>::value) {
+      ids.resize(num_edges);
+      weights.resize(num_edges);
+      #pragma omp parallel for
+      for (int64_t e = 0; e < num_edges; e++) {
+        ids[e] = neighs[e].v;
+        weights[e] = neighs[e].w;
+      }
+    }
+  }
+
+  // Places section after the last one, starting on an aligned boundary
+  static void AddSection(SGHeader &header, uint32_t type, uint32_t elem_bytes,
+                         uint64_t bytes) {
+    uint64_t end = sizeof(SGHeader);
+    if (header.num_sections != 0) {
+      const SGSection &last = header.sections[header.num_sections - 1];
+      end = last.offset + last.bytes;
+    }
+    SGSection &section = header.sections[header.num_sections++];
+    section.type = type;
+    section.elem_bytes = elem_bytes;
+    section.offset = SGAlignUp(end);
+    section.bytes = bytes;
+    section.checksum = 0;
+  }
+
+  static void WritePadding(std::fstream &out, uint64_t num_bytes) {
+    const char zeros[kSGAlignment] = {};
+    while (num_bytes > 0) {
+      uint64_t to_write = std::min(num_bytes, uint64_t(kSGAlignment));
+      out.write(zeros, to_write);
+      num_bytes -= to_write;
+    }
+  }
+
+  CSRGraphT &g_;
   std::string filename_;
 };
 
@@ -7,7 +7,11 @@
 #-----------------------------------------------------------------------#
 
 # Dependencies are the tests it will run
-test-all: test-build test-generate test-load test-verify
+test-all: test-build test-generate test-load test-partitioned test-in-place \
+          test-tiering test-cache test-serialize test-weighted-serialize \
+          test-encoded test-binary-el test-compressed test-wide-ids \
+          test-weight-types \
+          test-verify test-inverse test-lazy-inverse test-reorder
 
 # Does everthing, intended target for users
 test: test-score
@@ -53,7 +57,7 @@ test-generate-%: test/out/generate-%.out
 
 # Loading graphs from files
 test-load: test-load-4.gr test-load-4.el test-load-4.wel test-load-4.graph \
-					 test-load-4w.graph test-load-4.mtx test-load-4w.mtx
+					 test-load-4w.graph test-load-4.mtx test-load-4w.mtx test-load-4.sg
 
 test/out/load-%.out: test/out $(GENERATE_KERNEL)
 	./$(GENERATE_KERNEL) -f test/graphs/$* -n0 > $@
@@ -66,6 +70,245 @@ test-load-%: test/out/load-%.out
 	fi
 
 
+# Building with the partitioned (atomic-free) CSR builder
+test-partitioned: test-partitioned-4.el test-partitioned-4w.mtx
+
+test/out/partitioned-%.out: test/out $(GENERATE_KERNEL)
+	./$(GENERATE_KERNEL) -B partitioned -f test/graphs/$* -n0 > $@
+
+.SECONDARY:
+test-partitioned-%: test/out/partitioned-%.out
+	@if grep -q "`cat test/reference/graph-$*.out`" $<; \
+		then echo " $(PASS) Partitioned build $*"; \
+		else echo " $(FAIL) Partitioned build $*"; \
+	fi
+
+# Placing graphs on memory tiers (single tier, so classified but not moved),
+# generated since the tiny test graphs fit in a page and leave both tiers empty
+test-tiering: test-tiering-g16
+
+test/out/tiering-%.out: test/out $(GENERATE_KERNEL)
+	./$(GENERATE_KERNEL) -T 0:0:0.5 -$* -n0 > $@
+
+.SECONDARY:
+test-tiering-%: test/out/tiering-%.out
+	@if grep -q "Fast Plan MB: *[1-9]" $< && \
+			grep -q "Slow Plan MB: *[1-9]" $< && \
+			grep -q "Tier Moved MB: *0$$" $<; \
+		then echo " $(PASS) Tiered placement $*"; \
+		else echo " $(FAIL) Tiered placement $*"; \
+	fi
+
+# Build cache (-C), loading the same input again should hit
+test-cache: test-cache-4.el test-cache-4w.mtx
+
+test/out/cache-%.out: test/out $(GENERATE_KERNEL)
+	rm -rf test/out/cache-$*
+	./$(GENERATE_KERNEL) -C test/out/cache-$* -f test/graphs/$* -n0 > /dev/null
+	./$(GENERATE_KERNEL) -C test/out/cache-$* -f test/graphs/$* -n0 > $@
+
+.SECONDARY:
+test-cache-%: test/out/cache-%.out
+	@if grep -q "`cat test/reference/graph-$*.out`" $< && \
+			grep -q "Build Cache: *hit" $<; \
+		then echo " $(PASS) Build cache $*"; \
+		else echo " $(FAIL) Build cache $*"; \
+	fi
+
+# Building weighted graphs in place (-m)
+test-in-place: test-in-place-4.wel test-in-place-4w.mtx test-in-place-parallel
+
+test/out/in-place-%.out: test/out converter
+	./converter -wm -f test/graphs/$* -e /dev/null > $@
+
+.SECONDARY:
+test-in-place-%: test/out/in-place-%.out
+	@if grep -q "`cat test/reference/graph-$*.out`" $<; \
+		then echo " $(PASS) In-place weighted build $*"; \
+		else echo " $(FAIL) In-place weighted build $*"; \
+	fi
+
+# Large enough that in-place building splits its edge sort across threads
+test/out/in-place-parallel.out: test/out bfs
+	OMP_NUM_THREADS=4 ./bfs -g14 -m -vn1 > $@
+
+test-in-place-parallel: test/out/in-place-parallel.out
+	@if grep -q "Verification:           PASS" $<; \
+		then echo " $(PASS) In-place parallel build"; \
+		else echo " $(FAIL) In-place parallel build"; \
+	fi
+
+# Serializing graphs with converter and loading them back (read & mmap)
+test-serialize: test-serialize-4.el test-serialize-4.mtx
+
+test/out/serialize-%.sg: test/out converter
+	./converter -f test/graphs/$* -cb $@ > /dev/null
+
+test/out/serialize-%.out: test/out/serialize-%.sg $(GENERATE_KERNEL)
+	./$(GENERATE_KERNEL) -f $< -n0 > $@
+	./$(GENERATE_KERNEL) -lf $< -n0 >> $@
+
+.SECONDARY:
+test-serialize-%: test/out/serialize-%.out
+	@if [ `grep -c "\`cat test/reference/graph-$*.out\`" $<` -eq 2 ]; \
+		then echo " $(PASS) Serialize $*"; \
+		else echo " $(FAIL) Serialize $*"; \
+	fi
+
+# Serializing weighted graphs (weights stored apart from neighbors) and
+# converting them back, which should match converting the input directly
+test-weighted-serialize: test-weighted-serialize-4.wel \
+                         test-weighted-serialize-4w.mtx
+
+test/out/wserialize-%.wsg: test/out converter
+	./converter -f test/graphs/$* -wb $@ > /dev/null
+
+test/out/wserialize-%.wel: test/out/wserialize-%.wsg
+	./converter -f $< -we $@ > /dev/null
+
+test/out/wserialize-%.expected: test/out converter
+	./converter -f test/graphs/$* -we $@ > /dev/null
+
+.SECONDARY:
+test-weighted-serialize-%: test/out/wserialize-%.wel \
+                           test/out/wserialize-%.expected
+	@if cmp -s $^; \
+		then echo " $(PASS) Weighted serialize $*"; \
+		else echo " $(FAIL) Weighted serialize $*"; \
+	fi
+
+# Serializing with compressed (encoded) neighbors and loading them back
+test-encoded: test-encoded-4.el test-encoded-4.mtx
+
+test/out/encoded-%.sg: test/out converter
+	./converter -f test/graphs/$* -zb $@ > /dev/null
+
+test/out/encoded-%.out: test/out/encoded-%.sg $(GENERATE_KERNEL)
+	./$(GENERATE_KERNEL) -f $< -n0 > $@
+	./$(GENERATE_KERNEL) -lf $< -n0 >> $@
+
+.SECONDARY:
+test-encoded-%: test/out/encoded-%.out
+	@if [ `grep -c "\`cat test/reference/graph-$*.out\`" $<` -eq 2 ]; \
+		then echo " $(PASS) Encoded serialize $*"; \
+		else echo " $(FAIL) Encoded serialize $*"; \
+	fi
+
+# Converting to binary edge lists and loading them back
+test-binary-el: test-binary-el-4.el test-binary-el-4.wel
+
+test/out/binary-4.el.bel: test/out converter
+	./converter -f test/graphs/4.el -e $@ > /dev/null
+
+test/out/binary-4.wel.bwel: test/out converter
+	./converter -f test/graphs/4.wel -we $@ > /dev/null
+
+test/out/binary-%.out: test/out/binary-%.bel $(GENERATE_KERNEL)
+	./$(GENERATE_KERNEL) -f $< -n0 > $@
+
+test/out/binary-%.out: test/out/binary-%.bwel $(GENERATE_KERNEL)
+	./$(GENERATE_KERNEL) -f $< -n0 > $@
+
+.SECONDARY:
+test-binary-el-%: test/out/binary-%.out
+	@if grep -q "`cat test/reference/graph-$*.out`" $<; \
+		then echo " $(PASS) Binary edge list $*"; \
+		else echo " $(FAIL) Binary edge list $*"; \
+	fi
+
+# Loading gzip compressed text formats (decompressed while parsing)
+test-compressed: test-compressed-4.el test-compressed-4.graph \
+                 test-compressed-4w.mtx
+
+test/out/compressed-%.gz: test/graphs/% test/out
+	gzip -c $< > $@
+
+test/out/compressed-%.out: test/out/compressed-%.gz $(GENERATE_KERNEL)
+	./$(GENERATE_KERNEL) -f $< -n0 > $@
+
+.SECONDARY:
+test-compressed-%: test/out/compressed-%.out
+	@if grep -q "`cat test/reference/graph-$*.out`" $<; \
+		then echo " $(PASS) Compressed $*"; \
+		else echo " $(FAIL) Compressed $*"; \
+	fi
+
+
+# 64-bit IDs, serialized by 64-bit converter, so the 32-bit kernel loading
+# them runs its 64-bit build instead (see id_width.h)
+test-wide-ids: test-wide-ids-4.el test-wide-ids-4.mtx
+
+test/out/wide-ids-%.sg: test/out converter64
+	./converter64 -f test/graphs/$* -b $@ > /dev/null
+
+test/out/wide-ids-%.out: test/out/wide-ids-%.sg $(GENERATE_KERNEL) \
+                         $(GENERATE_KERNEL)64
+	./$(GENERATE_KERNEL) -f $< -n0 > $@
+
+.SECONDARY:
+test-wide-ids-%: test/out/wide-ids-%.out
+	@if grep -q "`cat test/reference/graph-$*.out`" $< && \
+			grep -q "Vertex IDs: *64-bit" $<; \
+		then echo " $(PASS) 64-bit IDs $*"; \
+		else echo " $(FAIL) 64-bit IDs $*"; \
+	fi
+
+
+# Other weight types (WEIGHT=..., see Makefile), built here since the suite
+# uses the default, .wsg files record their weight type, so binaries built
+# with another one reject them
+test-weight-types: test-weight-types-uint8 test-weight-types-float \
+                   test-weight-types-wsg test-weight-types-mismatch \
+                   test-weight-types-cache
+
+weight_type = $(if $(filter float double, $(1)),$(1),$(1)_t)
+
+test/out/weighted-%: test/out src/*.h
+	$(CXX) $(CXX_FLAGS) -DGAPBS_WEIGHT_T=$(call weight_type,$(lastword \
+		$(subst -, ,$*))) src/$(firstword $(subst -, ,$*)).cc -o $@ $(LIBS)
+
+test/out/weights-%.out: test/out/weighted-sssp-%
+	./$< -$(TEST_GRAPH) -vn1 > $@
+
+test/out/weights-uint8.wsg: test/out/weighted-converter-uint8
+	./$< -f test/graphs/4.wel -wb $@ > /dev/null
+
+test/out/weights-wsg.out: test/out/weights-uint8.wsg \
+                          test/out/weighted-sssp-uint8
+	./test/out/weighted-sssp-uint8 -f $< -vn1 > $@
+
+test/out/weights-mismatch.out: test/out/weights-uint8.wsg \
+                               test/out/weighted-sssp-float
+	./test/out/weighted-sssp-float -f $< -vn1 > $@ || true
+
+test/out/weights-cache.out: test/out/weighted-sssp-uint8
+	rm -rf test/out/weights-cache
+	./$< -C test/out/weights-cache -f test/graphs/4.wel -n0 > /dev/null
+	./$< -C test/out/weights-cache -f test/graphs/4.wel -vn1 > $@
+
+.SECONDARY:
+test-weight-types-cache: test/out/weights-cache.out
+	@if grep -q "Build Cache: *hit" $< && \
+			grep -q "Verification:           PASS" $<; \
+		then echo " $(PASS) Build cache uint8 weights"; \
+		else echo " $(FAIL) Build cache uint8 weights"; \
+	fi
+
+.SECONDARY:
+test-weight-types-mismatch: test/out/weights-mismatch.out
+	@if grep -q "has uint8 weights but expected float" $<; \
+		then echo " $(PASS) Weight type mismatch rejected"; \
+		else echo " $(FAIL) Weight type mismatch rejected"; \
+	fi
+
+.SECONDARY:
+test-weight-types-%: test/out/weights-%.out
+	@if grep -q "Verification:           PASS" $<; \
+		then echo " $(PASS) Weight type $*"; \
+		else echo " $(FAIL) Weight type $*"; \
+	fi
+
+
 
 # Kernel Output Verification -------------------------------------------#
 #-----------------------------------------------------------------------#
@@ -84,3 +327,78 @@ test-verify-%-$(TEST_GRAPH): test/out/verify-%-$(TEST_GRAPH).out
 	fi
 
 test-verify: $(addsuffix -$(TEST_GRAPH), $(addprefix test-verify-, $(KERNELS)))
+
+# Directed graphs make their inverse before kernels that need it run (pr
+# pulls from it), by transposing if built from an edge list, or else from the
+# .sg's inverse sections (read or memory-mapped)
+test-inverse: test-inverse-el test-inverse-sg test-inverse-mmap
+
+test/out/inverse.sg: test/out converter
+	./converter -f test/graphs/4.el -b $@ > /dev/null
+
+test/out/inverse-el.out: test/out pr
+	./pr -f test/graphs/4.el -vn1 > $@
+
+test/out/inverse-sg.out: test/out/inverse.sg pr
+	./pr -f $< -vn1 > $@
+
+test/out/inverse-mmap.out: test/out/inverse.sg pr
+	./pr -lf $< -vn1 > $@
+
+.SECONDARY:
+test-inverse-%: test/out/inverse-%.out
+	@if grep -q "Verification:           PASS" $< && \
+			grep -q "Inverse Time" $<; \
+		then echo " $(PASS) Inverse $*"; \
+		else echo " $(FAIL) Inverse $*"; \
+	fi
+
+# Kernels declaring kNeedsLazyInverse only make it when first used (bfs
+# verifier reads it), so runs without trials never make it
+test-lazy-inverse: test-lazy-inverse-used test-lazy-inverse-unused
+
+test/out/lazy-inverse-used.out: test/out bfs
+	./bfs -f test/graphs/4.el -vn1 > $@
+
+test/out/lazy-inverse-unused.out: test/out bfs
+	./bfs -f test/graphs/4.el -n0 > $@
+
+test-lazy-inverse-used: test/out/lazy-inverse-used.out
+	@if grep -q "Verification:           PASS" $< && \
+			grep -q "Inverse Time" $<; \
+		then echo " $(PASS) Lazy inverse used"; \
+		else echo " $(FAIL) Lazy inverse used"; \
+	fi
+
+test-lazy-inverse-unused: test/out/lazy-inverse-unused.out
+	@if grep -q "Build Time" $< && ! grep -q "Inverse Time" $<; \
+		then echo " $(PASS) Lazy inverse unused"; \
+		else echo " $(FAIL) Lazy inverse unused"; \
+	fi
+
+# Kernels on reordered graphs (bfs, since every kernel reorders the same)
+REORDERINGS = degree hub-sort hub-cluster dbg rcm gorder
+
+test/out/reorder-%-$(TEST_GRAPH).out: test/out bfs
+	./bfs -$(TEST_GRAPH) -R $* -vn1 > $@
+
+.SECONDARY:
+test-reorder-%-$(TEST_GRAPH): test/out/reorder-%-$(TEST_GRAPH).out
+	@if grep -q "Verification:           PASS" $<; \
+		then echo " $(PASS) Reorder $*"; \
+		else echo " $(FAIL) Reorder $*"; \
+	fi
+
+# Directed, so in-neighbors are relabeled too (pr pulls from them)
+test/out/reorder-directed.out: test/out pr
+	./pr -f test/graphs/4.el -R degree:in -vn1 > $@
+
+test-reorder-directed: test/out/reorder-directed.out
+	@if grep -q "Verification:           PASS" $<; \
+		then echo " $(PASS) Reorder directed"; \
+		else echo " $(FAIL) Reorder directed"; \
+	fi
+
+test-reorder: $(addsuffix -$(TEST_GRAPH), $(addprefix test-reorder-, \
+                                           $(REORDERINGS))) \
+              test-reorder-directed